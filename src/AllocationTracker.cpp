@@ -0,0 +1,169 @@
+/*
+ AllocationTracker.cpp
+ OscarUniverse
+
+ AllocationTracker class: in builds with OSCAR_TRACK_ALLOCATIONS defined, the global operator new is replaced to count
+ heap allocations and bytes in the current frame phase. Only the threads of the frame loop are counted: the render
+ thread and the job system workers while they run a chunk of the frame stages; the loader, decoder, encoder,
+ simulation and metrics threads allocate at their own pace and are not charged to the frame. Every 5 seconds the log
+ shows the allocations of the last frame and the worst frame of each phase; a steady frame loop should show zeros
+ everywhere
+ */
+
+#include "AllocationTracker.h"
+
+#ifdef OSCAR_TRACK_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+//the counters are constant-initialized, so they work also for the allocations made before main
+static std::atomic<int> currentPhase(AllocationTracker::EVENTS);
+static std::atomic<bool> paused(false);
+static std::atomic<uint64_t> frameCounts[AllocationTracker::PHASES];
+static std::atomic<uint64_t> frameBytes[AllocationTracker::PHASES];
+static thread_local bool isThreadTracked = false;   //true on the threads whose allocations are counted
+
+//statistics of the frames, only used by the main thread
+static uint64_t maxCounts[AllocationTracker::PHASES];      //allocations of the worst frame since the last log
+static uint64_t maxBytes[AllocationTracker::PHASES];
+static uint64_t totalCounts[AllocationTracker::PHASES];    //allocations of the whole run
+static uint64_t frames = 0;
+static uint64_t framesWithAllocations = 0;
+static float lastLogTime = 0.f;
+
+static const char * phaseNames[AllocationTracker::PHASES] = {"events", "update", "layout", "draw", "gui"};
+
+
+//--------------------------------------------------------------
+void AllocationTracker::setPhase(Phase phase) {
+    currentPhase.store(phase, std::memory_order_relaxed);
+}
+
+
+//--------------------------------------------------------------
+void AllocationTracker::trackThread(bool b) {
+    isThreadTracked = b;
+}
+
+
+//--------------------------------------------------------------
+void AllocationTracker::count(size_t bytes) {
+    if(!isThreadTracked || paused.load(std::memory_order_relaxed)) {
+        return;
+    }
+    int phase = currentPhase.load(std::memory_order_relaxed);
+    frameCounts[phase].fetch_add(1, std::memory_order_relaxed);
+    frameBytes[phase].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+
+//--------------------------------------------------------------
+void AllocationTracker::endFrame() {
+    //the log itself allocates, it is not counted
+    paused = true;
+
+    uint64_t counts[PHASES];
+    uint64_t bytes[PHASES];
+    bool hasAllocations = false;
+    for(int p = 0; p < PHASES; p++) {
+        counts[p] = frameCounts[p].exchange(0);
+        bytes[p] = frameBytes[p].exchange(0);
+        maxCounts[p] = max(maxCounts[p], counts[p]);
+        maxBytes[p] = max(maxBytes[p], bytes[p]);
+        totalCounts[p] += counts[p];
+        hasAllocations = hasAllocations || counts[p] > 0;
+    }
+    frames++;
+    if(hasAllocations) {
+        framesWithAllocations++;
+    }
+
+    float now = ofGetElapsedTimef();
+    if(now - lastLogTime > 5.f) {
+        ostringstream line;
+        line << "allocations (last frame / worst frame):";
+        for(int p = 0; p < PHASES; p++) {
+            line << " " << phaseNames[p] << " " << counts[p] << " (" << bytes[p] << " B) / "
+                 << maxCounts[p] << " (" << maxBytes[p] << " B)";
+            maxCounts[p] = 0;
+            maxBytes[p] = 0;
+        }
+        ofLogNotice("AllocationTracker") << line.str();
+        lastLogTime = now;
+    }
+
+    setPhase(EVENTS);
+    paused = false;
+}
+
+
+//--------------------------------------------------------------
+void AllocationTracker::writeSummary() {
+    paused = true;
+    ostringstream line;
+    line << framesWithAllocations << " of " << frames << " frames allocated on the heap, total allocations:";
+    for(int p = 0; p < PHASES; p++) {
+        line << " " << phaseNames[p] << " " << totalCounts[p];
+    }
+    ofLogNotice("AllocationTracker") << line.str();
+    paused = false;
+}
+
+
+//OPERATORS
+//--------------------------------------------------------------
+void * operator new(size_t size) {
+    AllocationTracker::count(size);
+    void * pointer = malloc(size == 0 ? 1 : size);
+    if(!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+
+//--------------------------------------------------------------
+void * operator new[](size_t size) {
+    return operator new(size);
+}
+
+
+//--------------------------------------------------------------
+void * operator new(size_t size, const std::nothrow_t &) noexcept {
+    AllocationTracker::count(size);
+    return malloc(size == 0 ? 1 : size);
+}
+
+
+//--------------------------------------------------------------
+void * operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return operator new(size, std::nothrow);
+}
+
+
+//--------------------------------------------------------------
+void operator delete(void * pointer) noexcept {
+    free(pointer);
+}
+
+
+//--------------------------------------------------------------
+void operator delete[](void * pointer) noexcept {
+    free(pointer);
+}
+
+
+//--------------------------------------------------------------
+void operator delete(void * pointer, size_t size) noexcept {
+    free(pointer);
+}
+
+
+//--------------------------------------------------------------
+void operator delete[](void * pointer, size_t size) noexcept {
+    free(pointer);
+}
+
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "ofMain.h"   //includes the Header file of OpenFrameworks
+
+//heap allocations of each frame phase, counted only in builds with OSCAR_TRACK_ALLOCATIONS defined and only on the
+//threads that opt in (the render thread and the workers of the frame stages); in the other builds the functions are
+//empty and operator new is not replaced
+class AllocationTracker {
+
+    public:
+        //phases of a frame
+        enum Phase {
+            EVENTS,   //between two frames: input events, window and buffer swap
+            UPDATE,   //ofApp::update except the frame stages
+            LAYOUT,   //layout, projection, culling and picking of the boxes
+            DRAW,     //3D scene
+            GUI,      //panels and texts
+            PHASES    //number of phases
+        };
+
+#ifdef OSCAR_TRACK_ALLOCATIONS
+        static void setPhase(Phase phase);      //the next allocations are counted in 'phase'
+        static void trackThread(bool b);        //if true, the allocations of the calling thread are counted
+        static void endFrame();                 //closes the counters of the frame, they are logged periodically
+        static void count(size_t bytes);        //called by operator new
+        static void writeSummary();             //writes in the log the allocations of the whole run
+#else
+        static void setPhase(Phase phase) {}
+        static void trackThread(bool b) {}
+        static void endFrame() {}
+        static void writeSummary() {}
+#endif
+};
@@ -8,60 +8,81 @@
  */
 
 #include "FilmBox.h"
+#include "StateCache.h"
+#include "ProcessStats.h"
 
 //typedef
 typedef ofPoint dimensions;   //this typedef is used to save width and height values in a single variable
 
+//uploads an image in a texture of the box; an image that could not be decoded leaves the face empty, instead of showing
+//the movie that used the box before
+static bool uploadImage(ofTexture & texture, const TextureCache::Image & image) {
+    if(!image.levels.empty()) {
+        TextureCache::upload(texture, image);
+        return true;
+    }
+    if(texture.isAllocated()) {
+        texture.clear();
+        ProcessStats::addTextures(-1);
+    }
+    return false;
+}
+
 //static variables inside a class should be initialized explicitly outside the class
 ofParameter<float> FilmBox::volumeSoundtrack;
 ofParameter<float> FilmBox::volumeTrailer;
 ofParameter<int> FilmBox::rotationSpeed;
 ofParameterGroup FilmBox::filmBoxGroup;
+ofBoxPrimitive FilmBox::outerBox;
+ofBoxPrimitive FilmBox::innerBox;
+dimensions FilmBox::dimensionBox;
+dimensions FilmBox::dimensionInnerBox;
+dimensions FilmBox::textureDimension;
+dimensions FilmBox::dimensionTrailer;
+ofPoint FilmBox::texturePosition;
 
 
 //--------------------------------------------------------------
 FilmBox::FilmBox() {
-    dimensionBox = ofPoint(100.f, 100.f * 1.5, 100.f);   //the height of the movie box is proportional to its width
-    dimensionInnerBox = ofPoint(dimensionBox.x - 0.2,
-                                dimensionBox.y - 0.2,
-                                dimensionBox.z - 0.2); //inner movie box is slightly smaller than outer movie box
-    texturePosition = ofPoint(- dimensionInnerBox.x/2 * 0.8,
-                              - dimensionInnerBox.y/2 * 0.8,
-                              0.3 - dimensionInnerBox.z/2);   //textures are slightly in front of inner box surface
-    textureDimension = ofPoint(dimensionInnerBox.x * 0.8, dimensionInnerBox.y * 0.8);   //80% inner box face dimension
-    dimensionTrailer = ofPoint(dimensionInnerBox.x, dimensionInnerBox.x * 0.56);   //height is proportional to width
-    
-    trailerCoords.resize(2);
-
     playIconTexture = NULL;
     
-    rotationBox = 0;
-    rotationStep = 0;
-    
     isBoxHorizontal = false;
+    
+    //the volumes are applied only when the GUI sliders move, not at every frame
+    trailerVolumeListener = volumeTrailer.newListener([this](float & volume) {
+        if(trailer.isLoaded()) {
+            trailer.setVolume(volume);
+        }
+    });
+    soundtrackVolumeListener = volumeSoundtrack.newListener([this](float & volume) {
+        if(soundtrack.isLoaded()) {
+            soundtrack.setVolume(volume);
+        }
+    });
 }
 
 
 //--------------------------------------------------------------
 FilmBox::~FilmBox(){
-    playIconTexture = NULL;
-    delete playIconTexture;
+    playIconTexture = NULL;   //the play icon texture is owned by ofApp, it must not be deleted here
+    closeMedia();
+    for(ofTexture * texture : {&poster, &movieInfoTexture, &movieAwardsTexture, &movieBackground}) {
+        if(texture -> isAllocated()) {
+            ProcessStats::addTextures(-1);
+        }
+    }
 }
 
 
 //METHODS
 //--------------------------------------------------------------
-void FilmBox::display() {
-    innerBox.setParent(outerBox);   //external box is parent of the inner box
-    
-    //EXTERNAL BOX
-    outerBox.set(dimensionBox.x, dimensionBox.y, dimensionBox.z);
-    
+void FilmBox::display(const ofPoint & worldPos, int rotation) {
+    //the shared meshes are drawn in the origin, the matrix moves them in the position of the movie box
     ofPushMatrix();
-    ofTranslate(worldPosBox);
-    outerBox.setPosition(0,0,0);
-    ofRotateYDeg(rotationBox);
+    ofTranslate(worldPos);
+    ofRotateYDeg(rotation);
     
+    //EXTERNAL BOX
     //the poster covers the surface of the external box
     poster.bind();
     outerBox.draw();
@@ -69,9 +90,6 @@ void FilmBox::display() {
     
     
     //INNER BOX
-    innerBox.set(dimensionInnerBox.x, dimensionInnerBox.y, dimensionInnerBox.z);
-    innerBox.setPosition(0, 0, 0);
-    
     //'movieBackground' image covers the surface of the inner box
     movieBackground.bind();
     innerBox.draw();
@@ -98,78 +116,63 @@ void FilmBox::display() {
     movieAwardsTexture.draw(texturePosition, textureDimension.x, textureDimension.y);
     ofPopMatrix();
     
+    ofPopMatrix();
+}
+
+
+//--------------------------------------------------------------
+void FilmBox::displayTrailer(const ofPoint & worldPos, int rotation) {
+    //same transformation of display, the trailer is drawn apart so that its GPU time can be measured
+    ofPushMatrix();
+    ofTranslate(worldPos);
+    ofRotateYDeg(rotation);
     
     //FACE BOX WITH TRAILER
     glPushMatrix();
     glRotatef(180, 0, 1, 0);                 //needed because the video is flipped
     glTranslatef(0, 0, texturePosition.z);   //translation on the z axis
     
-    trailer.setAnchorPoint(dimensionTrailer.x/2, dimensionTrailer.y/2);
-    trailer.draw(0, 0, dimensionTrailer.x, dimensionTrailer.y);
-    
-    //if the video is paused, the play icon is shown
-    if(trailer.isPaused()) {
-        glEnable(GL_CULL_FACE);
-        glCullFace(GL_FRONT);   //in this mode, when the camera moves inside the box, the play icon is not seen
-        playIconTexture -> draw(ofPoint(0, 0, 0.2),
-                                dimensionTrailer.y/2,
-                                dimensionTrailer.y/2);   //play icon sizes the half of trailer height
-        glDisable(GL_CULL_FACE);
-    }
+    //centered without an anchor point, which would be set on the video texture at every draw
+    trailer.draw(-dimensionTrailer.x/2, -dimensionTrailer.y/2, dimensionTrailer.x, dimensionTrailer.y);
     glPopMatrix();
     
-    //stop video trailer
-    trailer.setLoopState(OF_LOOP_NONE);   //the video stops when it ends
-    
     ofPopMatrix();
-    outerBox.setPosition(worldPosBox);   //resets correct external box position
-    
-    trailerCoords[0] = ofPoint(worldPosBox.x - dimensionTrailer.x/2,
-                               worldPosBox.y + dimensionTrailer.y/2,
-                               worldPosBox.z + 0.3 - dimensionInnerBox.z/2);   //top left corner
-    trailerCoords[1] = ofPoint(worldPosBox.x + dimensionTrailer.x/2,
-                               worldPosBox.y - dimensionTrailer.y/2,
-                               worldPosBox.z + 0.3 - dimensionInnerBox.z/2);   //bottom right corner
 }
 
 
 //--------------------------------------------------------------
-void FilmBox::rotateBox(char orientation) {
-    if(rotationStep < 90) {   //check if the 90° rotation is over
-        
-        if(rotationStep + rotationSpeed <= 90) {
-            
-            if(orientation == 'r') {         //gradual rotation to the right
-                rotationBox += rotationSpeed % 360;
-            } else if(orientation == 'l'){   //gradual rotation to the left
-                rotationBox -= rotationSpeed % 360;
-            }
-            
-            rotationStep += rotationSpeed;
-        } else {   //if the sum is greater than 90°, the missing value is added to reach 90°
-            
-            if(orientation == 'r') {
-                rotationBox += (rotationStep + rotationSpeed - 90) % 360 ;
-            } else if(orientation == 'l'){
-                rotationBox -= (rotationStep + rotationSpeed - 90) % 360;
-            }
-            
-            rotationStep += rotationStep + rotationSpeed - 90;
-        }
+void FilmBox::displayPlayIcon(const ofPoint & worldPos, int rotation) {
+    //if the video is paused, the play icon is shown on the trailer; a closed trailer has no icon
+    if(!trailer.isLoaded() || !trailer.isPaused()) {
+        return;
     }
+    
+    //culling is left enabled for the next icons, the caller disables it after the last one
+    StateCache::setCullFace(true);
+    StateCache::setCullFaceMode(GL_FRONT);   //in this mode, when the camera moves inside the box, the icon is not seen
+    
+    ofPushMatrix();
+    ofTranslate(worldPos);
+    ofRotateYDeg(rotation);
+    glPushMatrix();
+    glRotatef(180, 0, 1, 0);                 //same transformation of the trailer
+    glTranslatef(0, 0, texturePosition.z);
+    
+    playIconTexture -> draw(ofPoint(0, 0, 0.2),
+                            dimensionTrailer.y/2,
+                            dimensionTrailer.y/2);   //play icon sizes the half of trailer height
+    glPopMatrix();
+    ofPopMatrix();
 }
 
 
 //--------------------------------------------------------------
 void FilmBox::update() {
     //trailer
-    trailer.update();                   //updates the movie trailer internal state to continue playback
-    trailer.setVolume(volumeTrailer);   //updates trailer volume
+    trailer.update();   //updates the movie trailer internal state to continue playback
     
     //soundtrack
-    ofSoundUpdate();                          //updates sound engine
-    soundtrack.setVolume(volumeSoundtrack);   //updates soundtrack volume
-    
+    ofSoundUpdate();    //updates sound engine
 }
 
 
@@ -198,6 +201,64 @@ void FilmBox::settingAudioControls(bool b) {
 }
 
 
+//--------------------------------------------------------------
+void FilmBox::openMedia() {
+    if(trailer.isLoaded()) {
+        return;
+    }
+    
+    //movie trailer, its state is set once here and then changed only by the GUI
+    trailer.load(idMovie + "/" + idMovie + ".mp4");
+    trailer.setLoopState(OF_LOOP_NONE);   //the video stops when it ends
+    trailer.setVolume(volumeTrailer);
+    
+    //movie soundtrack, streamed so that opening it does not decode the whole file
+    soundtrack.setLoop(true);   //loops the sound
+    soundtrack.load(idMovie + "/" + idMovie + ".mp3", true);
+    soundtrack.setVolume(volumeSoundtrack);
+}
+
+
+//--------------------------------------------------------------
+void FilmBox::closeMedia() {
+    //the players and the textures are kept, the object is reused with another movie through setImages
+    if(trailer.isLoaded()) {
+        trailer.close();
+    }
+    if(soundtrack.isLoaded()) {
+        soundtrack.unload();
+    }
+}
+
+
+//--------------------------------------------------------------
+void FilmBox::setupBoxes() {
+    dimensionBox = ofPoint(100.f, 100.f * 1.5, 100.f);   //the height of the movie box is proportional to its width
+    dimensionInnerBox = ofPoint(dimensionBox.x - 0.2,
+                                dimensionBox.y - 0.2,
+                                dimensionBox.z - 0.2); //inner movie box is slightly smaller than outer movie box
+    texturePosition = ofPoint(- dimensionInnerBox.x/2 * 0.8,
+                              - dimensionInnerBox.y/2 * 0.8,
+                              0.3 - dimensionInnerBox.z/2);   //textures are slightly in front of inner box surface
+    textureDimension = ofPoint(dimensionInnerBox.x * 0.8, dimensionInnerBox.y * 0.8);   //80% inner box face dimension
+    dimensionTrailer = ofPoint(dimensionInnerBox.x, dimensionInnerBox.x * 0.56);   //height is proportional to width
+    
+    //the meshes are generated once, instead of every time a movie box is drawn
+    outerBox.set(dimensionBox.x, dimensionBox.y, dimensionBox.z);
+    outerBox.setPosition(0, 0, 0);
+    innerBox.set(dimensionInnerBox.x, dimensionInnerBox.y, dimensionInnerBox.z);
+    innerBox.setPosition(0, 0, 0);
+}
+
+
+//--------------------------------------------------------------
+void FilmBox::clearBoxes() {
+    //the static meshes would otherwise release their buffers after the GL context is destroyed
+    outerBox = ofBoxPrimitive();
+    innerBox = ofBoxPrimitive();
+}
+
+
 //--------------------------------------------------------------
 void FilmBox::setupParametersGroup() {
     //setup ofParameter attributes
@@ -218,56 +279,49 @@ void FilmBox::setupParametersGroup() {
 //SETTER
 //--------------------------------------------------------------
 void FilmBox::setId(string idMovie) {
-    
-    //poster
-    ofLoadImage(poster, idMovie + "/" + idMovie + ".jpg");
-    poster.generateMipmap();
-    poster.setTextureMinMagFilter(GL_LINEAR_MIPMAP_LINEAR, GL_NEAREST);   //antialiasing effect in textures
-    
-    //information about movie name, director, genres and plot
-    ofLoadImage(movieInfoTexture, idMovie + "/" + idMovie + "1.png");
-    movieInfoTexture.generateMipmap();
-    movieInfoTexture.setTextureMinMagFilter(GL_LINEAR_MIPMAP_LINEAR, GL_NEAREST);   //antialiasing effect in textures
-    
-    //information about movie awards and nominations
-    ofLoadImage(movieAwardsTexture, idMovie + "/" + idMovie + "2.png");
-    movieAwardsTexture.generateMipmap();
-    movieInfoTexture.setTextureMinMagFilter(GL_LINEAR_MIPMAP_LINEAR, GL_NEAREST);   //antialiasing effect in textures
-    
-    //background of the inner box
-    ofLoadImage(movieBackground, idMovie + "/" + idMovie + "b.jpg");
-    movieBackground.mirror(false, true);   //the image is flipped horizontally because inside the box we see its back face
-    
-    //movie trailer
-    trailer.load(idMovie + "/" + idMovie + ".mp4");
-    
-    //movie soundtrack
-    soundtrack.setLoop(true);   //loops the sound
-    soundtrack.load(idMovie + "/" + idMovie + ".mp3");
-}
-
-
-//--------------------------------------------------------------
-void FilmBox::setWorldPosBox(int x, int y, int z) {
-    worldPosBox = ofPoint(x, y, z);
-}
-
-
-//--------------------------------------------------------------
-void FilmBox::setScreenPosBox(int x, int y) {
-    screenPosBox = ofPoint(x, y);
+    Images images;
+    decodeImages(idMovie, images);
+    setImages(idMovie, images);
 }
 
 
 //--------------------------------------------------------------
-void FilmBox::setRotationStep(int n) {
-    rotationStep = n;
+bool FilmBox::decodeImages(string idMovie, Images & images) {
+    //poster and information textures are decoded with their mipmaps only once, then read from the cache
+    bool decoded = TextureCache::decode(images.poster, idMovie + "/" + idMovie + ".jpg", true);
+    decoded &= TextureCache::decode(images.movieInfo, idMovie + "/" + idMovie + "1.png", true);
+    decoded &= TextureCache::decode(images.movieAwards, idMovie + "/" + idMovie + "2.png", true);
+    
+    //background of the inner box, flipped horizontally because inside the box we see its back face; the cache stores
+    //it already flipped
+    decoded &= TextureCache::decode(images.movieBackground, idMovie + "/" + idMovie + "b.jpg", false, true);
+    return decoded;
 }
 
 
 //--------------------------------------------------------------
-void FilmBox::setRotationBox(int n) {
-    rotationBox = n;
+void FilmBox::setImages(string id, const Images & images) {
+    //a box recycled from another movie keeps its textures, they are refilled when the sizes match
+    closeMedia();
+    idMovie = id;
+    
+    //poster
+    if(uploadImage(poster, images.poster)) {
+        poster.setTextureMinMagFilter(GL_LINEAR_MIPMAP_LINEAR, GL_NEAREST);   //antialiasing effect in textures
+    }
+    
+    //information about movie name, director, genres and plot
+    if(uploadImage(movieInfoTexture, images.movieInfo)) {
+        movieInfoTexture.setTextureMinMagFilter(GL_LINEAR_MIPMAP_LINEAR, GL_NEAREST);   //antialiasing effect in textures
+    }
+    
+    //information about movie awards and nominations
+    if(uploadImage(movieAwardsTexture, images.movieAwards)) {
+        movieInfoTexture.setTextureMinMagFilter(GL_LINEAR_MIPMAP_LINEAR, GL_NEAREST);   //antialiasing effect in textures
+    }
+    
+    //background of the inner box
+    uploadImage(movieBackground, images.movieBackground);
 }
 
 
@@ -279,36 +333,41 @@ void FilmBox::setPlayIconTexture(ofTexture *texture) {
 
 //GETTER
 //--------------------------------------------------------------
-ofPoint FilmBox::getWorldPosBox() {
-    return worldPosBox;
+ofVideoPlayer & FilmBox::getTrailer() {
+    return trailer;
 }
 
 
 //--------------------------------------------------------------
-ofBoxPrimitive FilmBox::getBox() {
-    return outerBox;
+ofSoundPlayer & FilmBox::getSoundtrack() {
+    return soundtrack;
 }
 
 
 //--------------------------------------------------------------
-int FilmBox::getRotationStep() {
-    return rotationStep;
+const ofBoxPrimitive & FilmBox::getBox() {
+    return outerBox;
 }
 
 
 //--------------------------------------------------------------
-int FilmBox::getRotationBox() {
-    return rotationBox;
+const ofPoint & FilmBox::getDimensionBox() {
+    return dimensionBox;
 }
 
 
 //--------------------------------------------------------------
-vector<ofPoint> FilmBox::getTrailerCoords() {
-    return trailerCoords;
+int FilmBox::getRotationSpeed() {
+    return rotationSpeed;
 }
 
 
 //--------------------------------------------------------------
-ofVideoPlayer FilmBox::getTrailer() {
-    return trailer;
+void FilmBox::getTrailerCoords(const ofPoint & worldPos, ofPoint & topLeft, ofPoint & bottomRight) {
+    topLeft = ofPoint(worldPos.x - dimensionTrailer.x/2,
+                      worldPos.y + dimensionTrailer.y/2,
+                      worldPos.z + 0.3 - dimensionInnerBox.z/2);   //top left corner
+    bottomRight = ofPoint(worldPos.x + dimensionTrailer.x/2,
+                          worldPos.y - dimensionTrailer.y/2,
+                          worldPos.z + 0.3 - dimensionInnerBox.z/2);   //bottom right corner
 }
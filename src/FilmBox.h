@@ -1,41 +1,49 @@
 #pragma once
 
 #include "ofMain.h"   //includes the Header file of OpenFrameworks
+#include "TextureCache.h"
 
 class FilmBox {
     
     //typedef
     typedef ofPoint dimensions;   //this typedef is used to save width, height and depth values in a single variable
     
+    public:
+        //images of a movie decoded off the render thread, uploaded by setImages
+        struct Images {
+            TextureCache::Image poster;
+            TextureCache::Image movieInfo;
+            TextureCache::Image movieAwards;
+            TextureCache::Image movieBackground;
+        };
+    
     private:
         //ATTRIBUTES
+        string idMovie;                 //movie shown by the box, its folder contains the images and the media
         ofTexture poster;               //movie poster
         ofTexture movieInfoTexture;     //texture with information about the movie (name, director, genres, plot)
         ofTexture movieAwardsTexture;   //texture with information about nominations  and awards won by the movie
         ofTexture * playIconTexture;    //pointer to play icon texture to show on the video trailer when it is paused
     
-        ofImage movieBackground;    //image to use as background of the inner movie box
-        ofVideoPlayer trailer;      //movie trailer
-        ofSoundPlayer soundtrack;   //movie soundtrack
-    
-        ofBoxPrimitive outerBox;   //external movie box (it is covered with the movie poster)
-        ofBoxPrimitive innerBox;   //inner movie box (it shows the information about the movie)
+        ofTexture movieBackground;   //image to use as background of the inner movie box
+        ofVideoPlayer trailer;       //movie trailer, open only while the movie is selected or captured
+        ofSoundPlayer soundtrack;    //movie soundtrack, open only while the movie is selected or captured
     
-        dimensions dimensionBox;        //dimensions of the external movie box
-        dimensions dimensionInnerBox;   //dimensions of the inner movie box
-        dimensions textureDimension;    //dimension of all inner box textures
-        dimensions dimensionTrailer;    //dimension of movie trailer
+        //all movie boxes have the same size, so they share dimensions and meshes
+        static ofBoxPrimitive outerBox;   //external movie box (it is covered with the movie poster)
+        static ofBoxPrimitive innerBox;   //inner movie box (it shows the information about the movie)
     
-        vector<ofPoint> trailerCoords;   //vector of trailer coordinates [Top-Left, Bottom-Right]
-        ofPoint texturePosition;         //position of all inner box textures
-        ofPoint worldPosBox;             //movie box position in world coordinates
-        ofPoint screenPosBox;            //movie box position in screen coordinates
-    
-        int rotationBox;    //angle rotation of the movie box
-        int rotationStep;   //current movie box rotation performed (from 0° to 90°)
+        static dimensions dimensionBox;        //dimensions of the external movie box
+        static dimensions dimensionInnerBox;   //dimensions of the inner movie box
+        static dimensions textureDimension;    //dimension of all inner box textures
+        static dimensions dimensionTrailer;    //dimension of movie trailer
+        static ofPoint texturePosition;        //position of all inner box textures
     
         bool isBoxHorizontal;   //if true, the movie box is drawn horizontally
     
+        ofEventListener trailerVolumeListener;      //applies 'volumeTrailer' to the trailer when it changes
+        ofEventListener soundtrackVolumeListener;   //applies 'volumeSoundtrack' to the soundtrack when it changes
+    
         //GUI attributes
         static ofParameter<float> volumeSoundtrack;   //soundtrack volume in range [0.f - 1.f]
         static ofParameter<float> volumeTrailer;      //trailer volume in range [0.f - 1.f]
@@ -48,26 +56,29 @@ class FilmBox {
         ~FilmBox();   //FilmBox class decontructor. It is invoked automatically when it is called a delete on an object
     
         //SETTER
-        void setId(string idMovie);
-        void setWorldPosBox(int x, int y, int z);
-        void setScreenPosBox(int x, int y);
-        void setRotationStep(int n);
-        void setRotationBox(int n);
+        void setId(string idMovie);                                  //decodes and uploads the images on this thread
+        void setImages(string idMovie, const Images & images);       //uploads images decoded by decodeImages
         void setPlayIconTexture(ofTexture * texture);
+        static bool decodeImages(string idMovie, Images & images);   //it can be called from any thread
     
         //GETTER
-        ofPoint getWorldPosBox();
-        ofBoxPrimitive getBox();
-        int getRotationStep();
-        int getRotationBox();
-        vector<ofPoint> getTrailerCoords();
-        ofVideoPlayer getTrailer();
+        ofVideoPlayer & getTrailer();
+        ofSoundPlayer & getSoundtrack();
+        static const ofBoxPrimitive & getBox();
+        static const ofPoint & getDimensionBox();
+        static int getRotationSpeed();
+        static void getTrailerCoords(const ofPoint & worldPos, ofPoint & topLeft, ofPoint & bottomRight);
     
         //METHODS
-        void display();            //draw the FilmBox object
-        void rotateBox(char orientation);                        //rotate movie box, orientation can only be 'r' or 'l'
+        void display(const ofPoint & worldPos, int rotation);   //draw the FilmBox object
+        void displayTrailer(const ofPoint & worldPos, int rotation);   //draw the trailer face of the FilmBox object
+        void displayPlayIcon(const ofPoint & worldPos, int rotation);  //draw the play icon if the trailer is paused
         void update();                                           //update trailer frame and soundtrack of the movie
         void settingVideoControls();                             //set video trailer to play or pause
         void settingAudioControls(bool b);                       //set soundtrack to play or pause
+        void openMedia();                                        //opens trailer and soundtrack of the movie
+        void closeMedia();                                       //closes trailer and soundtrack, the textures are kept
         static void setupParametersGroup();                      //add parameters to ParameterGroup
+        static void setupBoxes();                                //setup dimensions and meshes shared by all movie boxes
+        static void clearBoxes();                                //releases the shared meshes while the GL context exists
 };
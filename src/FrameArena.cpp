@@ -0,0 +1,71 @@
+/*
+ FrameArena.cpp
+ OscarUniverse
+
+ FrameArena class: bump allocator for the data that lives for a single frame. An allocation only moves an offset and
+ the whole arena is released at the end of the frame. When a frame needs more memory than the arena has, a new block
+ is added; at the next reset the blocks are merged in one, so in steady state the arena never touches the heap
+ */
+
+#include "FrameArena.h"
+
+
+//--------------------------------------------------------------
+FrameArena::FrameArena(size_t initialSize) {
+    blocks.push_back(unique_ptr<char[]>(new char[initialSize]));
+    blockSizes.push_back(initialSize);
+    block = 0;
+    offset = 0;
+    used = 0;
+    highWater = 0;
+}
+
+
+//--------------------------------------------------------------
+void * FrameArena::allocateBytes(size_t bytes, size_t alignment) {
+    size_t aligned = (offset + alignment - 1) / alignment * alignment;
+
+    //the current block is full: the next one is used, or a new one is added
+    if(aligned + bytes > blockSizes[block]) {
+        block++;
+        if(block == blocks.size()) {
+            size_t size = max(bytes + alignment, blockSizes.back() * 2);
+            blocks.push_back(unique_ptr<char[]>(new char[size]));
+            blockSizes.push_back(size);
+        }
+        aligned = 0;   //the blocks are aligned for any fundamental type
+    }
+
+    offset = aligned + bytes;
+    used += bytes;
+    return blocks[block].get() + aligned;
+}
+
+
+//--------------------------------------------------------------
+void FrameArena::reset() {
+    highWater = max(highWater, used);
+
+    //the frame did not fit in the first block: the blocks are replaced by one that holds the whole frame
+    if(blocks.size() > 1) {
+        size_t size = 0;
+        for(auto blockSize : blockSizes) {
+            size += blockSize;
+        }
+        blocks.clear();
+        blockSizes.clear();
+        blocks.push_back(unique_ptr<char[]>(new char[size]));
+        blockSizes.push_back(size);
+    }
+
+    block = 0;
+    offset = 0;
+    used = 0;
+}
+
+
+//GETTER
+//--------------------------------------------------------------
+size_t FrameArena::getHighWater() {
+    return highWater;
+}
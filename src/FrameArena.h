@@ -0,0 +1,32 @@
+#pragma once
+
+#include "ofMain.h"   //includes the Header file of OpenFrameworks
+
+class FrameArena {
+
+    private:
+        //ATTRIBUTES
+        vector<unique_ptr<char[]>> blocks;   //memory of the arena, a single block once the high-water mark is known
+        vector<size_t> blockSizes;           //size of each block in bytes
+        size_t block;                        //block currently used
+        size_t offset;                       //first free byte of the current block
+        size_t used;                         //bytes allocated in the current frame
+        size_t highWater;                    //largest number of bytes allocated in a frame
+
+        void * allocateBytes(size_t bytes, size_t alignment);
+
+    public:
+        //INTERFACE
+        FrameArena(size_t initialSize = 64 * 1024);   //FrameArena class constructor
+
+        //uninitialized array of 'count' objects, valid until the next reset; only for types without destructor
+        template<class T> T * allocate(size_t count) {
+            static_assert(std::is_trivially_destructible<T>::value, "the arena never calls destructors");
+            return static_cast<T *>(allocateBytes(sizeof(T) * count, alignof(T)));
+        }
+
+        void reset();   //releases everything allocated in the frame
+
+        //GETTER
+        size_t getHighWater();
+};
@@ -0,0 +1,268 @@
+/*
+ FrameCapture.cpp
+ OscarUniverse
+
+ FrameCapture class: headless export of the universe. Each movie box is rendered from outside and from its four inner
+ faces, then a camera path around each galaxy is rendered as a numbered PNG sequence. Frames are drawn in an FBO of
+ any size, copied to a ring of pixel buffer objects and mapped only when a fence says that the GPU has filled them;
+ the PNG encoding runs on worker threads
+ */
+
+#include "FrameCapture.h"
+#include "ProcessStats.h"
+
+
+//--------------------------------------------------------------
+FrameCapture::FrameCapture() {
+    running = false;
+    nextShot = 0;
+    shotCount = 0;
+    nextSlot = 0;
+    inFlight = 0;
+    startTime = 0.f;
+    capturedFrames = 0;
+    stalls = 0;
+    for(auto & slot : slots) {
+        slot.fence = 0;
+        slot.pending = false;
+    }
+}
+
+
+//--------------------------------------------------------------
+FrameCapture::~FrameCapture() {
+    frames.close();
+    for(auto & encoder : encoders) {
+        encoder -> waitForThread(true);
+    }
+}
+
+
+//--------------------------------------------------------------
+bool FrameCapture::start(string dir, int width, int height, const vector<string> & movies,
+                         const vector<string> & galaxies) {
+    if(!ofDirectory::createDirectory(dir, true, true)) {
+        ofLogError("FrameCapture") << "unable to create " << dir;
+        return false;
+    }
+
+    directory = dir;
+    movieIds = movies;
+    galaxyNames = galaxies;
+    nextShot = 0;
+    shotCount = movieIds.size() * 5 + galaxyNames.size() * PATH_FRAMES;   //outer view and 4 faces for each movie
+
+    //offscreen target and readback ring
+    ofFbo::Settings settings;
+    settings.width = width;
+    settings.height = height;
+    settings.internalformat = GL_RGBA;
+    settings.numSamples = 4;
+    settings.useDepth = true;
+    if(!fbo.isAllocated()) {
+        ProcessStats::addTextures(1);   //color texture, the depth and the multisampled targets are render buffers
+        ProcessStats::addBuffers(READBACK_SLOTS);
+    }
+    fbo.allocate(settings);
+    for(auto & slot : slots) {
+        slot.buffer.allocate(width * height * 4, GL_STREAM_READ);
+        slot.pending = false;
+    }
+    nextSlot = 0;
+
+    //one encoder for each spare core
+    int threads = ofClamp((int)std::thread::hardware_concurrency() - 1, 1, 4);
+    for(int i = 0; i < threads; i++) {
+        encoders.push_back(unique_ptr<Encoder>(new Encoder()));
+        encoders.back() -> capture = this;
+        encoders.back() -> startThread();
+    }
+
+    running = true;
+    startTime = ofGetElapsedTimef();
+    capturedFrames = 0;
+    stalls = 0;
+
+    ofLogNotice("FrameCapture") << "capturing " << shotCount << " frames at " << width << "x" << height << " in " << dir;
+    return true;
+}
+
+
+//--------------------------------------------------------------
+bool FrameCapture::getNextShot(Shot & shot) {
+    if(nextShot >= shotCount) {
+        return false;
+    }
+
+    size_t boxShots = movieIds.size() * 5;
+    if(nextShot < boxShots) {
+        shot.movie = nextShot / 5;
+        shot.face = nextShot % 5 - 1;
+        shot.type = shot.face < 0 ? OUTER : INNER;
+
+        string folder = directory + "/" + movieIds[shot.movie];
+        if(shot.type == OUTER) {
+            ofDirectory::createDirectory(folder, true, true);
+            shot.file = folder + "/outer.png";
+        } else {
+            shot.file = folder + "/face" + ofToString(shot.face) + ".png";
+        }
+    } else {
+        int frame = (nextShot - boxShots) % PATH_FRAMES;
+        shot.type = PATH;
+        shot.galaxy = (nextShot - boxShots) / PATH_FRAMES;
+        shot.t = frame / (float)(PATH_FRAMES - 1);
+
+        string folder = directory + "/paths/" + galaxyNames[shot.galaxy];
+        if(frame == 0) {
+            ofDirectory::createDirectory(folder, true, true);
+        }
+        shot.file = folder + "/frame_" + ofToString(frame, 5, '0') + ".png";
+    }
+
+    nextShot++;
+    return true;
+}
+
+
+//--------------------------------------------------------------
+void FrameCapture::begin() {
+    fbo.begin();
+    ofClear(0, 0, 0, 255);
+}
+
+
+//--------------------------------------------------------------
+void FrameCapture::end() {
+    fbo.end();
+}
+
+
+//--------------------------------------------------------------
+void FrameCapture::readback(string file) {
+    //the ring is full only when the GPU is several frames behind, then the oldest frame must be waited for
+    Slot & slot = slots[nextSlot];
+    if(slot.pending) {
+        finishSlot(slot, true);
+    }
+
+    //the copy is queued in the GL command stream, the CPU does not wait for it
+    fbo.getTexture().copyTo(slot.buffer);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.file = file;
+    slot.pending = true;
+
+    nextSlot = (nextSlot + 1) % READBACK_SLOTS;
+}
+
+
+//--------------------------------------------------------------
+void FrameCapture::poll() {
+    //the slots are finished in the order in which they were filled
+    for(int i = 0; i < READBACK_SLOTS; i++) {
+        Slot & slot = slots[(nextSlot + i) % READBACK_SLOTS];
+        if(!slot.pending) {
+            continue;
+        }
+        GLenum status = glClientWaitSync(slot.fence, 0, 0);
+        if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            break;
+        }
+        finishSlot(slot, false);
+    }
+}
+
+
+//--------------------------------------------------------------
+void FrameCapture::finishSlot(Slot & slot, bool wait) {
+    if(wait) {
+        GLenum status = glClientWaitSync(slot.fence, 0, 0);
+        if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            stalls++;
+            glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);   //1 second
+        }
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = 0;
+    slot.pending = false;
+
+    //the pixels of a frame already encoded are reused when possible
+    Frame frame;
+    recycled.tryReceive(frame.pixels);
+    unsigned char * data = slot.buffer.map<unsigned char>(GL_READ_ONLY);
+    frame.pixels.setFromPixels(data, fbo.getWidth(), fbo.getHeight(), OF_PIXELS_RGBA);
+    slot.buffer.unmap();
+
+    frame.file = slot.file;
+    inFlight++;
+    capturedFrames++;
+    frames.send(std::move(frame));
+}
+
+
+//--------------------------------------------------------------
+void FrameCapture::finish() {
+    if(!running) {
+        return;
+    }
+    running = false;
+
+    //last frames of the ring
+    for(int i = 0; i < READBACK_SLOTS; i++) {
+        Slot & slot = slots[(nextSlot + i) % READBACK_SLOTS];
+        if(slot.pending) {
+            finishSlot(slot, true);
+        }
+    }
+
+    //the encoders stop when all frames are saved
+    while(inFlight > 0) {
+        ofSleepMillis(5);
+    }
+    frames.close();
+    for(auto & encoder : encoders) {
+        encoder -> waitForThread(true);
+    }
+    encoders.clear();
+
+    float seconds = ofGetElapsedTimef() - startTime;
+    ofLogNotice("FrameCapture") << capturedFrames << " frames captured in " << seconds << " s ("
+                                << capturedFrames / max(seconds, 0.001f) << " frames/s), " << stalls
+                                << " readbacks waited for the GPU";
+}
+
+
+//--------------------------------------------------------------
+void FrameCapture::Encoder::threadedFunction() {
+    Frame frame;
+    while(capture -> frames.receive(frame)) {
+        ofSaveImage(frame.pixels, frame.file);
+        capture -> recycled.send(std::move(frame.pixels));
+        capture -> inFlight--;
+    }
+}
+
+
+//GETTER
+//--------------------------------------------------------------
+bool FrameCapture::isRunning() {
+    return running;
+}
+
+
+//--------------------------------------------------------------
+bool FrameCapture::isReady() {
+    return inFlight < MAX_IN_FLIGHT;
+}
+
+
+//--------------------------------------------------------------
+float FrameCapture::getWidth() {
+    return fbo.getWidth();
+}
+
+
+//--------------------------------------------------------------
+float FrameCapture::getHeight() {
+    return fbo.getHeight();
+}
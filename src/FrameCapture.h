@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ofMain.h"   //includes the Header file of OpenFrameworks
+
+class FrameCapture {
+
+    public:
+        //kinds of frames rendered by the capture
+        enum ShotType {
+            OUTER,   //movie box seen from outside
+            INNER,   //one of the four inner faces of a movie box
+            PATH     //frame of the camera path around a galaxy
+        };
+
+        struct Shot {
+            ShotType type;
+            int movie;      //index of the movie of OUTER and INNER shots
+            int face;       //inner face (0 to 3), the box is rotated by face * 90°
+            int galaxy;     //index of the galaxy of PATH shots
+            float t;        //position along the camera path, from 0 to 1
+            string file;    //PNG file written for the shot
+        };
+
+    private:
+        //frame read back from the GPU, waiting for the encoders
+        struct Frame {
+            string file;
+            ofPixels pixels;
+        };
+
+        //pixel buffer object receiving a frame, it is mapped only when the GPU has filled it
+        struct Slot {
+            ofBufferObject buffer;
+            GLsync fence;
+            string file;
+            bool pending;
+        };
+
+        //worker thread saving frames as PNG files
+        class Encoder : public ofThread {
+            public:
+                FrameCapture * capture;
+                void threadedFunction();
+        };
+
+        static const int READBACK_SLOTS = 3;     //frames that can be read back at the same time
+        static const int MAX_IN_FLIGHT = 16;     //frames waiting for the encoders before the capture pauses
+        static const int PATH_FRAMES = 240;      //frames of each camera path
+
+        //ATTRIBUTES
+        bool running;                            //if true, the capture drives the application
+        string directory;                        //folder where the frames are written
+        vector<string> movieIds;                 //names of the movie folders
+        vector<string> galaxyNames;              //names of the camera path folders
+        size_t nextShot;                         //index of the next shot
+        size_t shotCount;                        //total number of shots
+
+        ofFbo fbo;                               //offscreen target, its size does not depend on the window
+        Slot slots[READBACK_SLOTS];              //ring of pixel buffer objects
+        int nextSlot;                            //slot receiving the next frame
+        ofThreadChannel<Frame> frames;           //frames waiting for the encoders
+        ofThreadChannel<ofPixels> recycled;      //pixels already encoded, reused for the next frames
+        vector<unique_ptr<Encoder>> encoders;
+        std::atomic<int> inFlight;               //frames read back and not yet saved
+
+        //statistics
+        float startTime;
+        int capturedFrames;
+        int stalls;                              //readbacks that had to wait for the GPU
+
+        void finishSlot(Slot & slot, bool wait);   //maps a filled slot and sends its pixels to the encoders
+
+    public:
+        //INTERFACE
+        FrameCapture();    //FrameCapture class constructor
+        ~FrameCapture();   //FrameCapture class destructor, it stops the encoders
+
+        //starts capturing all movies and one camera path for each galaxy in 'dir'
+        bool start(string dir, int width, int height, const vector<string> & movies, const vector<string> & galaxies);
+        bool getNextShot(Shot & shot);   //returns false when all shots have been taken
+        void begin();                    //starts drawing in the offscreen target
+        void end();
+        void readback(string file);      //queues the readback of the frame just drawn, it does not wait for the GPU
+        void poll();                     //sends to the encoders the frames already filled by the GPU
+        void finish();                   //waits for the last frames and stops the encoders
+
+        //GETTER
+        bool isRunning();
+        bool isReady();                  //false while too many frames are waiting for the encoders
+        float getWidth();
+        float getHeight();
+};
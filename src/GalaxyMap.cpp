@@ -0,0 +1,343 @@
+/*
+ GalaxyMap.cpp
+ OscarUniverse
+
+ GalaxyMap class: clusters of movies (one for each awards year or category) placed on a grid. A far cluster is drawn
+ as a single impostor quad with a mosaic of its posters, decoded on a worker thread and uploaded tile by tile; when the
+ camera gets close the cluster is expanded into its ring of movie boxes. A ring shows at most RING_CAPACITY members: scrolling slides the members through it, and only the
+ members on the ring plus a prefetch margin have live assets, recycled from the pool of MovieStore
+ */
+
+#include "GalaxyMap.h"
+#include "ProcessStats.h"
+
+static const float GALAXY_SPACING = 1500.f;      //distance between the centers of two neighbouring clusters
+static const float EXPAND_DISTANCE = 1500.f;     //camera distance under which a cluster is expanded
+static const float COLLAPSE_DISTANCE = 2200.f;   //camera distance over which a cluster is collapsed (hysteresis)
+static const int IMPOSTOR_GRID = 4;              //posters on each side of the impostor mosaic
+static const int TILE_WIDTH = 48;                //size of a poster in the impostor mosaic
+static const int TILE_HEIGHT = 72;
+static const float IMPOSTOR_WIDTH = 600.f;       //size of the impostor quad in world coordinates
+static const float IMPOSTOR_HEIGHT = 900.f;
+static const int RING_CAPACITY = 18;             //boxes that fit on a ring without overlapping
+static const int PREFETCH_MARGIN = 4;            //members loaded on each side of the visible arc before they show
+static const float SEAM_ANGLE = -90.f;           //angle where the boxes leaving the ring are replaced by entering ones
+
+
+//--------------------------------------------------------------
+GalaxyMap::GalaxyMap() {
+    overviewPosition = ofPoint(0, 0, 0);
+    farClip = 0.f;
+    tileDecoder.galaxyMap = this;
+}
+
+
+//--------------------------------------------------------------
+GalaxyMap::~GalaxyMap() {
+    tileRequests.close();
+    decodedTiles.close();
+    if(tileDecoder.isThreadRunning()) {
+        tileDecoder.waitForThread(true);
+    }
+}
+
+
+//--------------------------------------------------------------
+int GalaxyMap::getGalaxy(string name) {
+    auto found = galaxyIndex.find(name);
+    if(found != galaxyIndex.end()) {
+        return found -> second;
+    }
+
+    Galaxy galaxy;
+    galaxy.name = name;
+    galaxy.ringSize = 0;
+    galaxy.angleOffset = 0;
+    galaxy.windowFirst = 0;
+    galaxy.windowEnd = 0;
+    galaxy.expanded = false;
+    galaxies.push_back(galaxy);
+
+    galaxyIndex[name] = galaxies.size() - 1;
+    return galaxies.size() - 1;
+}
+
+
+//--------------------------------------------------------------
+int GalaxyMap::addMember(int galaxy, MovieStore::MovieId id) {
+    galaxies[galaxy].members.push_back(id);
+    return galaxies[galaxy].members.size() - 1;
+}
+
+
+//--------------------------------------------------------------
+void GalaxyMap::layout(const MovieStore & movies) {
+    //clusters on a centered grid, a single cluster stays in the origin like the original ring
+    int columns = ceil(sqrt((float)galaxies.size()));
+    int rows = (galaxies.size() + columns - 1) / max(1, columns);
+
+    for(size_t i = 0; i < galaxies.size(); i++) {
+        Galaxy & galaxy = galaxies[i];
+        int column = i % columns;
+        int row = i / columns;
+        galaxy.center = ofPoint((column - (columns - 1) * 0.5f) * GALAXY_SPACING,
+                                ((rows - 1) * 0.5f - row) * GALAXY_SPACING, 0);
+        galaxy.ringSize = max(1, min(RING_CAPACITY, (int)galaxy.members.size()));
+        galaxy.angleOffset = 360.f / galaxy.ringSize;
+
+        //the posters of the mosaic are sampled across the whole cluster and decoded by the worker thread
+        int tiles = min(IMPOSTOR_GRID * IMPOSTOR_GRID, (int)galaxy.members.size());
+        for(int t = 0; t < tiles; t++) {
+            const string & idMovie = movies.getId(galaxy.members[t * galaxy.members.size() / tiles]);
+            Tile tile;
+            tile.galaxy = i;
+            tile.tile = t;
+            tile.file = idMovie + "/" + idMovie + ".jpg";
+            tileRequests.send(std::move(tile));
+        }
+    }
+    if(!tileDecoder.isThreadRunning()) {
+        tileDecoder.startThread();
+    }
+
+    //the overview camera sees the whole grid
+    float extent = max(columns, rows) * GALAXY_SPACING;
+    overviewPosition = ofPoint(0, 0, extent * 1.2f + 1000);
+    farClip = overviewPosition.z + extent;
+}
+
+
+//--------------------------------------------------------------
+bool GalaxyMap::update(const ofPoint & cameraPosition, float scrollAngle, MovieStore & movies, MovieStore::MovieId keep,
+                       int assetBudget) {
+    bool changed = false;
+    activeMovies.clear();
+
+    for(auto & galaxy : galaxies) {
+        float distance = cameraPosition.distance(galaxy.center);
+        if(!galaxy.expanded && distance < EXPAND_DISTANCE) {
+            galaxy.expanded = true;
+            changed = true;
+        } else if(galaxy.expanded && distance > COLLAPSE_DISTANCE) {
+            galaxy.expanded = false;
+            changed = true;
+        }
+
+        if(!galaxy.expanded) {
+            moveWindow(galaxy, 0, 0, movies, keep);   //all assets of the cluster are released
+            continue;
+        }
+
+        //visible arc: the positions starting from the seam, the scroll angle rotates the whole ring
+        int first = ceil((SEAM_ANGLE - scrollAngle) / galaxy.angleOffset);
+        int members = galaxy.members.size();
+        for(int p = first; p < first + galaxy.ringSize; p++) {
+            RingEntry entry;
+            entry.id = galaxy.members[(p % members + members) % members];   //the members repeat along the ring
+            entry.position = p;
+            activeMovies.push_back(entry);
+        }
+
+        moveWindow(galaxy, first - PREFETCH_MARGIN, first + galaxy.ringSize + PREFETCH_MARGIN, movies, keep);
+    }
+
+    //assets are loaded a few per frame, a negative budget loads all of them now
+    for(int i = 0; (assetBudget < 0 || i < assetBudget) && !pageInQueue.empty(); i++) {
+        MovieStore::MovieId id = pageInQueue.front();
+        pageInQueue.pop_front();
+
+        //the member may have left the window in the meantime
+        if(isPaged(movies, id)) {
+            movies.acquireAssets(id);
+        }
+    }
+
+    //posters already decoded by the worker thread, each upload copies only the rectangle of its tile
+    Tile tile;
+    while(decodedTiles.tryReceive(tile)) {
+        uploadImpostorTile(tile);
+    }
+
+    return changed;
+}
+
+
+//--------------------------------------------------------------
+void GalaxyMap::moveWindow(Galaxy & galaxy, int first, int end, MovieStore & movies, MovieStore::MovieId keep) {
+    int members = galaxy.members.size();
+    if(end - first >= members) {   //the whole cluster fits in the window, it never changes while scrolling
+        first = 0;
+        end = members;
+    }
+    if(first == galaxy.windowFirst && end == galaxy.windowEnd) {
+        return;
+    }
+
+    //only the positions of the old and the new window are visited, not the whole cluster
+    for(int p = galaxy.windowFirst; p < galaxy.windowEnd; p++) {
+        int member = (p % members + members) % members;
+        if(!isInWindow(member, first, end, members) && galaxy.members[member] != keep) {   //the selected movie keeps
+                                                                                       //its trailer and soundtrack
+            movies.releaseAssets(galaxy.members[member]);
+        }
+    }
+    for(int p = first; p < end; p++) {
+        int member = (p % members + members) % members;
+        if(!isInWindow(member, galaxy.windowFirst, galaxy.windowEnd, members)) {
+            pageInQueue.push_back(galaxy.members[member]);
+        }
+    }
+
+    galaxy.windowFirst = first;
+    galaxy.windowEnd = end;
+}
+
+
+//--------------------------------------------------------------
+bool GalaxyMap::isInWindow(int member, int first, int end, int members) {
+    return ((member - first) % members + members) % members < end - first;
+}
+
+
+//--------------------------------------------------------------
+void GalaxyMap::TileDecoder::threadedFunction() {
+    //decoding and scaling a poster is the slow part, it never runs on the render thread
+    Tile tile;
+    while(galaxyMap -> tileRequests.receive(tile)) {
+        if(ofLoadImage(tile.pixels, tile.file)) {
+            tile.pixels.setImageType(OF_IMAGE_COLOR);
+            tile.pixels.resize(TILE_WIDTH, TILE_HEIGHT);
+        } else {
+            tile.pixels.clear();
+        }
+        galaxyMap -> decodedTiles.send(std::move(tile));
+    }
+}
+
+
+//--------------------------------------------------------------
+void GalaxyMap::uploadImpostorTile(const Tile & tile) {
+    Galaxy & galaxy = galaxies[tile.galaxy];
+
+    //the mosaic is allocated black with the first poster, then the posters fill it
+    if(!galaxy.impostor.isAllocated()) {
+        ofPixels black;
+        black.allocate(IMPOSTOR_GRID * TILE_WIDTH, IMPOSTOR_GRID * TILE_HEIGHT, OF_PIXELS_RGB);
+        black.set(0);
+        galaxy.impostor.allocate(black);
+        galaxy.impostor.loadData(black);
+        ProcessStats::addTextures(1);
+    }
+    if(!tile.pixels.isAllocated()) {   //the poster could not be decoded, its tile stays black
+        return;
+    }
+
+    ofTextureData & data = galaxy.impostor.getTextureData();
+    glBindTexture(data.textureTarget, data.textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(data.textureTarget, 0, (tile.tile % IMPOSTOR_GRID) * TILE_WIDTH,
+                    (tile.tile / IMPOSTOR_GRID) * TILE_HEIGHT, TILE_WIDTH, TILE_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE,
+                    tile.pixels.getData());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(data.textureTarget, 0);
+}
+
+
+//--------------------------------------------------------------
+void GalaxyMap::drawImpostors(int hovered) {
+    for(size_t g = 0; g < galaxies.size(); g++) {
+        Galaxy & galaxy = galaxies[g];
+        if(galaxy.expanded) {
+            continue;
+        }
+
+        ofPoint corner = galaxy.center - ofPoint(IMPOSTOR_WIDTH / 2, IMPOSTOR_HEIGHT / 2, 0);
+
+        ofPushStyle();
+        if(galaxy.impostor.isAllocated()) {
+            galaxy.impostor.draw(corner, IMPOSTOR_WIDTH, IMPOSTOR_HEIGHT);
+        } else {   //placeholder until the first poster is ready
+            ofSetColor(40);
+            ofDrawRectangle(corner, IMPOSTOR_WIDTH, IMPOSTOR_HEIGHT);
+        }
+
+        ofSetColor(255);
+        ofDrawBitmapString(galaxy.name, corner - ofPoint(0, 20, 0));
+
+        if((int)g == hovered) {
+            ofNoFill();
+            ofSetLineWidth(3);
+            ofSetColor(212, 175, 55);   //gold
+            ofDrawRectangle(corner, IMPOSTOR_WIDTH, IMPOSTOR_HEIGHT);
+        }
+        ofPopStyle();
+    }
+}
+
+
+//--------------------------------------------------------------
+int GalaxyMap::intersects(const glm::vec3 & origin, const glm::vec3 & direction) const {
+    int nearest = -1;
+    float nearestDistance = numeric_limits<float>::max();
+    glm::vec3 halfSize(IMPOSTOR_WIDTH / 2, IMPOSTOR_HEIGHT / 2, 1);
+
+    for(size_t g = 0; g < galaxies.size(); g++) {
+        if(galaxies[g].expanded) {
+            continue;
+        }
+
+        glm::vec3 center = galaxies[g].center;
+        float distance;
+        if(MovieStore::intersectsBounds(origin, direction, center - halfSize, center + halfSize, distance) &&
+           distance < nearestDistance) {
+            nearest = g;
+            nearestDistance = distance;
+        }
+    }
+
+    return nearest;
+}
+
+
+//GETTER
+//--------------------------------------------------------------
+size_t GalaxyMap::size() const {
+    return galaxies.size();
+}
+
+
+//--------------------------------------------------------------
+const GalaxyMap::Galaxy & GalaxyMap::get(int galaxy) const {
+    return galaxies[galaxy];
+}
+
+
+//--------------------------------------------------------------
+const vector<GalaxyMap::RingEntry> & GalaxyMap::getActiveMovies() const {
+    return activeMovies;
+}
+
+
+//--------------------------------------------------------------
+bool GalaxyMap::isPagingDone() const {
+    return pageInQueue.empty();
+}
+
+
+//--------------------------------------------------------------
+bool GalaxyMap::isPaged(const MovieStore & movies, MovieStore::MovieId id) const {
+    const Galaxy & galaxy = galaxies[movies.getGalaxy(id)];
+    return isInWindow(movies.getRingSlot(id), galaxy.windowFirst, galaxy.windowEnd, galaxy.members.size());
+}
+
+
+//--------------------------------------------------------------
+const ofPoint & GalaxyMap::getOverviewPosition() const {
+    return overviewPosition;
+}
+
+
+//--------------------------------------------------------------
+float GalaxyMap::getFarClip() const {
+    return farClip;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "ofMain.h"   //includes the Header file of OpenFrameworks
+#include "MovieStore.h"
+
+class GalaxyMap {
+
+    public:
+        //cluster of movies (an awards year or a category)
+        struct Galaxy {
+            string name;                            //year or category of the cluster
+            ofPoint center;                         //center of the cluster in world coordinates
+            vector<MovieStore::MovieId> members;    //movies of the cluster
+            int ringSize;                           //boxes on the ring, the other members are reached by scrolling
+            float angleOffset;                      //offset angle between the boxes on the ring
+            int windowFirst;                        //first ring position whose member has live assets
+            int windowEnd;                          //ring position after the last one whose member has live assets
+            bool expanded;                          //if true, the members are drawn as movie boxes
+            ofTexture impostor;                     //aggregate impostor drawn when the cluster is far away
+        };
+
+        //movie box shown on a ring
+        struct RingEntry {
+            MovieStore::MovieId id;   //movie of the box
+            int position;             //position on the ring, the angle of the box is position * angleOffset
+        };
+
+    private:
+        //poster of an impostor mosaic, decoded and scaled by the tile decoder
+        struct Tile {
+            int galaxy;        //cluster of the mosaic
+            int tile;          //position of the poster in the mosaic
+            string file;       //poster image
+            ofPixels pixels;   //scaled poster, empty if the image could not be decoded
+        };
+
+        //worker thread decoding the posters of the mosaics, the render thread only uploads them
+        class TileDecoder : public ofThread {
+            public:
+                GalaxyMap * galaxyMap;
+                void threadedFunction();
+        };
+
+        //ATTRIBUTES
+        vector<Galaxy> galaxies;                        //all clusters of the universe
+        map<string, int> galaxyIndex;                   //index of each cluster by name
+        vector<RingEntry> activeMovies;                 //boxes on the visible arc of the expanded clusters
+        deque<MovieStore::MovieId> pageInQueue;         //members entered in a window waiting for their assets
+        ofPoint overviewPosition;                       //camera position from which all clusters are visible
+        float farClip;                                  //camera far clip needed by the overview
+        ofThreadChannel<Tile> tileRequests;             //posters waiting for the tile decoder
+        ofThreadChannel<Tile> decodedTiles;             //posters decoded and waiting for their upload
+        TileDecoder tileDecoder;
+
+        //moves the window of live assets of a cluster, members leaving it are released and the entering ones queued
+        void moveWindow(Galaxy & galaxy, int first, int end, MovieStore & movies, MovieStore::MovieId keep);
+        static bool isInWindow(int member, int first, int end, int members);
+        void uploadImpostorTile(const Tile & tile);    //copies a decoded poster in its rectangle of the mosaic
+
+    public:
+        //INTERFACE
+        GalaxyMap();    //GalaxyMap class constructor
+        ~GalaxyMap();   //GalaxyMap class destructor, it stops the tile decoder
+
+        int getGalaxy(string name);                                  //index of the cluster 'name', created if needed
+        int addMember(int galaxy, MovieStore::MovieId id);           //adds a movie to a cluster, returns its ring slot
+        void layout(const MovieStore & movies);    //places the clusters on a grid and starts decoding their mosaics
+
+        //updates expansion, visible arcs and paging, returns true if a cluster was expanded or collapsed
+        bool update(const ofPoint & cameraPosition, float scrollAngle, MovieStore & movies, MovieStore::MovieId keep,
+                    int assetBudget);
+        void drawImpostors(int hovered);                             //draws the collapsed clusters
+        int intersects(const glm::vec3 & origin, const glm::vec3 & direction) const;   //cluster hit by the ray or -1
+
+        //GETTER
+        size_t size() const;
+        const Galaxy & get(int galaxy) const;
+        const vector<RingEntry> & getActiveMovies() const;
+        bool isPagingDone() const;
+        bool isPaged(const MovieStore & movies, MovieStore::MovieId id) const;   //true if the movie is in a window
+        const ofPoint & getOverviewPosition() const;
+        float getFarClip() const;
+};
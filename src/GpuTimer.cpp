@@ -0,0 +1,164 @@
+/*
+ GpuTimer.cpp
+ OscarUniverse
+
+ GpuTimer class: GPU time of each render pass, measured with timestamp queries. The queries of a frame are read a few
+ frames later and only if the GPU has already answered them, so the measurement never stalls the pipeline
+ */
+
+#include "GpuTimer.h"
+
+
+//--------------------------------------------------------------
+GpuTimer::GpuTimer() {
+    supported = false;
+    frame = 0;
+    lastSummaryTime = 0.f;
+    lastLogTime = 0.f;
+    for(int p = 0; p < PASSES; p++) {
+        milliseconds[p] = 0.f;
+    }
+    for(int f = 0; f < FRAMES; f++) {
+        for(int p = 0; p < PASSES; p++) {
+            issued[f][p] = false;
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+void GpuTimer::setup() {
+#ifndef TARGET_OPENGLES
+    supported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+#endif
+    if(!supported) {
+        ofLogWarning("GpuTimer") << "timer queries are not supported, GPU times are not measured";
+        return;
+    }
+
+    glGenQueries(FRAMES * PASSES * 2, &queries[0][0][0]);
+}
+
+
+//--------------------------------------------------------------
+void GpuTimer::clear() {
+    if(supported) {
+        glDeleteQueries(FRAMES * PASSES * 2, &queries[0][0][0]);
+        supported = false;
+    }
+}
+
+
+//--------------------------------------------------------------
+void GpuTimer::beginFrame() {
+    if(!supported) {
+        return;
+    }
+
+    //the next slot of the ring holds the oldest frame
+    frame = (frame + 1) % FRAMES;
+    collect(frame);
+    for(int p = 0; p < PASSES; p++) {
+        issued[frame][p] = false;
+    }
+
+    float now = ofGetElapsedTimef();
+    if(now - lastLogTime > 10.f) {
+        ofLogNotice("GpuTimer") << getSummary();
+        lastLogTime = now;
+    }
+}
+
+
+//--------------------------------------------------------------
+void GpuTimer::begin(Pass pass) {
+#ifndef TARGET_OPENGLES
+    if(supported) {
+        glQueryCounter(queries[frame][pass][0], GL_TIMESTAMP);
+    }
+#endif
+}
+
+
+//--------------------------------------------------------------
+void GpuTimer::end(Pass pass) {
+#ifndef TARGET_OPENGLES
+    if(supported) {
+        glQueryCounter(queries[frame][pass][1], GL_TIMESTAMP);
+        issued[frame][pass] = true;
+    }
+#endif
+}
+
+
+//--------------------------------------------------------------
+void GpuTimer::collect(int slot) {
+#ifndef TARGET_OPENGLES
+    for(int p = 0; p < PASSES; p++) {
+        if(!issued[slot][p]) {
+            milliseconds[p] *= 0.9f;   //a pass that was not drawn costs nothing
+            continue;
+        }
+
+        //if the GPU is still behind, the frame is skipped rather than waited for
+        GLint available = 0;
+        glGetQueryObjectiv(queries[slot][p][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available) {
+            continue;
+        }
+
+        GLuint64 start, stop;
+        glGetQueryObjectui64v(queries[slot][p][0], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(queries[slot][p][1], GL_QUERY_RESULT, &stop);
+        milliseconds[p] = milliseconds[p] * 0.9f + (stop - start) / 1000000.f * 0.1f;
+    }
+#endif
+}
+
+
+//GETTER
+//--------------------------------------------------------------
+float GpuTimer::getMilliseconds(Pass pass) {
+    return milliseconds[pass];
+}
+
+
+//--------------------------------------------------------------
+const string & GpuTimer::getSummary() {
+    //rebuilt twice per second, so it is readable on screen and it is not allocated at every frame
+    float now = ofGetElapsedTimef();
+    if(supported && (summary.empty() || now - lastSummaryTime > 0.5f)) {
+        //formatted in a buffer on the stack, assign reuses the capacity of the string
+        char buffer[256];
+        int length = snprintf(buffer, sizeof(buffer), "GPU ms:");
+        float total = 0.f;
+        for(int p = 0; p < PASSES; p++) {
+            length += snprintf(buffer + length, sizeof(buffer) - length, " %s %.2f", getName((Pass)p).c_str(),
+                               milliseconds[p]);
+            total += milliseconds[p];
+        }
+        snprintf(buffer + length, sizeof(buffer) - length, " total %.2f", total);
+        summary.assign(buffer);
+        lastSummaryTime = now;
+    }
+    return summary;
+}
+
+
+//--------------------------------------------------------------
+string GpuTimer::getName(Pass pass) {
+    switch(pass) {
+        case BACKGROUND:
+            return "background";
+        case STATUETTE:
+            return "statuette";
+        case BOXES:
+            return "boxes";
+        case TRAILER:
+            return "trailer";
+        case GUI:
+            return "GUI";
+        default:
+            return "";
+    }
+}
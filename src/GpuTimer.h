@@ -0,0 +1,47 @@
+#pragma once
+
+#include "ofMain.h"   //includes the Header file of OpenFrameworks
+
+class GpuTimer {
+
+    public:
+        //render passes measured on the GPU
+        enum Pass {
+            BACKGROUND,   //full-screen sky image
+            STATUETTE,    //Oscar model lit by seven lights
+            BOXES,        //movie boxes with their mipmapped textures
+            TRAILER,      //trailer video textures
+            GUI,          //ofxGui panels, FPS and help text
+            PASSES        //number of passes
+        };
+
+    private:
+        static const int FRAMES = 3;   //frames of queries in flight, the oldest one is read while the others run
+
+        //ATTRIBUTES
+        bool supported;                        //false if the driver has no timer queries
+        GLuint queries[FRAMES][PASSES][2];     //timestamps at the beginning and at the end of each pass
+        bool issued[FRAMES][PASSES];           //true if the pass was drawn in that frame
+        int frame;                             //slot of the current frame in the ring
+        float milliseconds[PASSES];            //smoothed GPU time of each pass
+        string summary;                        //text with the time of each pass, rebuilt periodically
+        float lastSummaryTime;                 //time when 'summary' was rebuilt
+        float lastLogTime;                     //time when the times were last written in the log
+
+        void collect(int slot);                //reads the results of a frame if the GPU has finished it
+
+    public:
+        //INTERFACE
+        GpuTimer();   //GpuTimer class constructor
+
+        void setup();        //creates the queries, it must be called with a GL context
+        void clear();        //deletes the queries
+        void beginFrame();   //moves to the next frame of the ring and reads the oldest one
+        void begin(Pass pass);
+        void end(Pass pass);
+
+        //GETTER
+        float getMilliseconds(Pass pass);
+        const string & getSummary();
+        static string getName(Pass pass);
+};
@@ -0,0 +1,397 @@
+/*
+ InputRecorder.cpp
+ OscarUniverse
+
+ InputRecorder class: records the interaction of a visitor (mouse, keyboard and GUI parameters) in a compact text log
+ and feeds it back to the application frame by frame, so that the same session can be replayed and measured across builds
+ */
+
+#include "InputRecorder.h"
+#include "ProcessStats.h"
+
+//log header, the version is incremented when the line format changes
+static const string LOG_HEADER = "oscar-input";
+static const int LOG_VERSION = 2;   //2 added the scroll lines, version 1 logs are still replayed
+
+//resident memory is sampled every 'MEMORY_SAMPLE_FRAMES' frames
+static const uint64_t MEMORY_SAMPLE_FRAMES = 60;
+
+
+//--------------------------------------------------------------
+//looks for a parameter by name inside 'group' and its sub-groups
+static ofAbstractParameter * findParameter(ofParameterGroup & group, const string & name) {
+    for(size_t i = 0; i < group.size(); i++) {
+        ofAbstractParameter & parameter = group.get(i);
+
+        if(parameter.type() == typeid(ofParameterGroup).name()) {
+            ofAbstractParameter * found = findParameter(parameter.castGroup(), name);
+            if(found != NULL) {
+                return found;
+            }
+        } else if(parameter.getName() == name) {
+            return &parameter;
+        }
+    }
+    return NULL;
+}
+
+
+//--------------------------------------------------------------
+InputRecorder::InputRecorder() {
+    recording = false;
+    replaying = false;
+    dispatching = false;
+
+    nextEvent = 0;
+    endFrame = 0;
+
+    lastFrameMicros = 0;
+    memoryStart = 0;
+    memoryPeak = 0;
+    memoryEnd = 0;
+}
+
+
+//--------------------------------------------------------------
+InputRecorder::~InputRecorder() {
+    stop();
+}
+
+
+//--------------------------------------------------------------
+bool InputRecorder::startRecording(string path, ofParameterGroup & group) {
+    if(!logFile.open(path, ofFile::WriteOnly)) {
+        ofLogError("InputRecorder") << "unable to create log " << path;
+        return false;
+    }
+
+    logFile << LOG_HEADER << " " << LOG_VERSION << " " << ofGetWidth() << " " << ofGetHeight() << "\n";
+
+    parameters = group;
+    ofAddListener(parameters.parameterChangedE(), this, &InputRecorder::onParameterChanged);
+    recording = true;
+
+    ofLogNotice("InputRecorder") << "recording input to " << path;
+    return true;
+}
+
+
+//--------------------------------------------------------------
+bool InputRecorder::startReplay(string path, ofParameterGroup & group) {
+    ofBuffer buffer = ofBufferFromFile(path);
+    if(buffer.size() == 0) {
+        ofLogError("InputRecorder") << "unable to read log " << path;
+        return false;
+    }
+
+    events.clear();
+    nextEvent = 0;
+    endFrame = 0;
+
+    bool headerRead = false;
+    for(auto line : buffer.getLines()) {
+        if(line.empty()) {
+            continue;
+        }
+
+        istringstream stream(line);
+
+        //the first line contains the header
+        if(!headerRead) {
+            string header;
+            int version = 0;
+            stream >> header >> version;
+            if(header != LOG_HEADER || version < 1 || version > LOG_VERSION) {
+                ofLogError("InputRecorder") << path << " is not a supported input log";
+                return false;
+            }
+            headerRead = true;
+            continue;
+        }
+
+        InputEvent event;
+        event.x = 0;
+        event.y = 0;
+        event.button = 0;
+        event.scroll = 0.f;
+        stream >> event.frame >> event.type;
+
+        if(event.type == MOUSE_MOVED) {
+            stream >> event.x >> event.y;
+        } else if(event.type == MOUSE_RELEASED) {
+            stream >> event.x >> event.y >> event.button;
+        } else if(event.type == MOUSE_SCROLLED) {
+            stream >> event.x >> event.y >> event.scroll;
+        } else if(event.type == KEY_RELEASED) {
+            stream >> event.x;
+        } else if(event.type == PARAMETER) {
+            stream >> event.value;
+            stream >> ws;
+            getline(stream, event.name);   //the name of the parameter can contain spaces
+        } else if(event.type == END) {
+            endFrame = event.frame;
+            continue;
+        } else {
+            ofLogWarning("InputRecorder") << "unknown event skipped: " << line;
+            continue;
+        }
+
+        events.push_back(event);
+    }
+
+    //logs truncated by a crash have no end marker, the replay stops after the last event
+    if(endFrame == 0 && !events.empty()) {
+        endFrame = events.back().frame;
+    }
+
+    parameters = group;
+    replaying = true;
+
+    ofLogNotice("InputRecorder") << "replaying " << events.size() << " events (" << endFrame << " frames) from " << path;
+    return true;
+}
+
+
+//--------------------------------------------------------------
+void InputRecorder::stop() {
+    if(recording) {
+        ofRemoveListener(parameters.parameterChangedE(), this, &InputRecorder::onParameterChanged);
+
+        InputEvent event;
+        event.frame = ofGetFrameNum();
+        event.type = END;
+        writeEvent(event);
+
+        logFile.close();
+        recording = false;
+    }
+    replaying = false;
+}
+
+
+//GETTER
+//--------------------------------------------------------------
+bool InputRecorder::isRecording() {
+    return recording;
+}
+
+
+//--------------------------------------------------------------
+bool InputRecorder::isReplaying() {
+    return replaying;
+}
+
+
+//--------------------------------------------------------------
+bool InputRecorder::isDispatching() {
+    return dispatching;
+}
+
+
+//--------------------------------------------------------------
+bool InputRecorder::isReplayOver(uint64_t frame) {
+    return replaying && nextEvent >= events.size() && frame >= endFrame;
+}
+
+
+//RECORDING
+//--------------------------------------------------------------
+void InputRecorder::recordMouseMoved(int x, int y) {
+    if(!recording) {
+        return;
+    }
+    InputEvent event;
+    event.frame = ofGetFrameNum();
+    event.type = MOUSE_MOVED;
+    event.x = x;
+    event.y = y;
+    writeEvent(event);
+}
+
+
+//--------------------------------------------------------------
+void InputRecorder::recordMouseReleased(int x, int y, int button) {
+    if(!recording) {
+        return;
+    }
+    InputEvent event;
+    event.frame = ofGetFrameNum();
+    event.type = MOUSE_RELEASED;
+    event.x = x;
+    event.y = y;
+    event.button = button;
+    writeEvent(event);
+}
+
+
+//--------------------------------------------------------------
+void InputRecorder::recordMouseScrolled(int x, int y, float scrollY) {
+    if(!recording) {
+        return;
+    }
+    InputEvent event;
+    event.frame = ofGetFrameNum();
+    event.type = MOUSE_SCROLLED;
+    event.x = x;
+    event.y = y;
+    event.scroll = scrollY;
+    writeEvent(event);
+}
+
+
+//--------------------------------------------------------------
+void InputRecorder::recordKeyReleased(int key) {
+    if(!recording) {
+        return;
+    }
+    InputEvent event;
+    event.frame = ofGetFrameNum();
+    event.type = KEY_RELEASED;
+    event.x = key;
+    writeEvent(event);
+}
+
+
+//--------------------------------------------------------------
+void InputRecorder::onParameterChanged(ofAbstractParameter & parameter) {
+    InputEvent event;
+    event.frame = ofGetFrameNum();
+    event.type = PARAMETER;
+    event.name = parameter.getName();
+    event.value = parameter.toString();
+    writeEvent(event);
+}
+
+
+//--------------------------------------------------------------
+void InputRecorder::writeEvent(const InputEvent & event) {
+    logFile << event.frame << " " << event.type;
+
+    if(event.type == MOUSE_MOVED) {
+        logFile << " " << event.x << " " << event.y;
+    } else if(event.type == MOUSE_RELEASED) {
+        logFile << " " << event.x << " " << event.y << " " << event.button;
+    } else if(event.type == MOUSE_SCROLLED) {
+        logFile << " " << event.x << " " << event.y << " " << event.scroll;
+    } else if(event.type == KEY_RELEASED) {
+        logFile << " " << event.x;
+    } else if(event.type == PARAMETER) {
+        logFile << " " << event.value << " " << event.name;
+    }
+
+    logFile << "\n";
+}
+
+
+//REPLAY
+//--------------------------------------------------------------
+bool InputRecorder::popEvent(uint64_t frame, InputEvent & event) {
+    if(!replaying || nextEvent >= events.size() || events[nextEvent].frame > frame) {
+        return false;
+    }
+    event = events[nextEvent];
+    nextEvent++;
+    return true;
+}
+
+
+//--------------------------------------------------------------
+void InputRecorder::applyParameter(const InputEvent & event) {
+    ofAbstractParameter * parameter = findParameter(parameters, event.name);
+    if(parameter == NULL) {
+        ofLogWarning("InputRecorder") << "parameter '" << event.name << "' not found";
+        return;
+    }
+    parameter -> fromString(event.value);
+}
+
+
+//--------------------------------------------------------------
+void InputRecorder::setDispatching(bool b) {
+    dispatching = b;
+}
+
+
+//REPORT
+//--------------------------------------------------------------
+void InputRecorder::sampleFrame(uint64_t frame) {
+    uint64_t now = ofGetSystemTimeMicros();   //real time, it is not affected by the fixed rate clock of the replay
+
+    if(lastFrameMicros != 0) {
+        frameTimes.push_back((now - lastFrameMicros) / 1000.f);
+    }
+    lastFrameMicros = now;
+
+    if(frame % MEMORY_SAMPLE_FRAMES == 0) {
+        memoryEnd = ProcessStats::getResidentMemory();
+        if(memoryStart == 0) {
+            memoryStart = memoryEnd;
+        }
+        memoryPeak = max(memoryPeak, memoryEnd);
+    }
+}
+
+
+//--------------------------------------------------------------
+void InputRecorder::writeReport(string path) {
+    if(frameTimes.empty()) {
+        return;
+    }
+
+    vector<float> sorted = frameTimes;
+    sort(sorted.begin(), sorted.end());
+
+    float total = 0.f;
+    for(float t : sorted) {
+        total += t;
+    }
+
+    auto percentile = [&sorted](float p) {
+        return sorted[min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+    };
+
+    ofFile report(path, ofFile::WriteOnly);
+    report << "frames " << sorted.size() << "\n";
+    report << "duration_ms " << total << "\n";
+    report << "frame_ms_avg " << total / sorted.size() << "\n";
+    report << "frame_ms_min " << sorted.front() << "\n";
+    report << "frame_ms_p50 " << percentile(0.5f) << "\n";
+    report << "frame_ms_p95 " << percentile(0.95f) << "\n";
+    report << "frame_ms_p99 " << percentile(0.99f) << "\n";
+    report << "frame_ms_max " << sorted.back() << "\n";
+    report << "rss_start_bytes " << memoryStart << "\n";
+    report << "rss_end_bytes " << memoryEnd << "\n";
+    report << "rss_peak_bytes " << memoryPeak << "\n";
+
+    //the full list of frame times allows to compare distributions between builds
+    report << "frame_ms";
+    for(float t : frameTimes) {
+        report << " " << t;
+    }
+    report << "\n";
+
+    ofLogNotice("InputRecorder") << "report written to " << path;
+}
+
+
+//--------------------------------------------------------------
+bool InputRecorder::readWindowSize(string path, int & width, int & height) {
+    ofBuffer buffer = ofBufferFromFile(path);
+    if(buffer.size() == 0) {
+        return false;
+    }
+
+    string header;
+    int version = 0;
+    int w = 0;
+    int h = 0;
+    istringstream stream(buffer.getFirstLine());
+    stream >> header >> version >> w >> h;
+
+    if(header != LOG_HEADER || version < 1 || version > LOG_VERSION || w <= 0 || h <= 0) {
+        return false;
+    }
+    width = w;
+    height = h;
+    return true;
+}
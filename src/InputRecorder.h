@@ -0,0 +1,82 @@
+#pragma once
+
+#include "ofMain.h"   //includes the Header file of OpenFrameworks
+
+class InputRecorder {
+
+    public:
+        //event types, the value is the character used in the log file
+        enum EventType {
+            MOUSE_MOVED = 'm',
+            MOUSE_RELEASED = 'r',
+            MOUSE_SCROLLED = 's',
+            KEY_RELEASED = 'k',
+            PARAMETER = 'p',
+            END = 'e'
+        };
+
+        struct InputEvent {
+            uint64_t frame;   //frame in which the event was received
+            char type;        //one of EventType values
+            int x;            //mouse x position or key code
+            int y;            //mouse y position
+            int button;       //mouse button
+            float scroll;     //vertical scroll of the mouse wheel
+            string name;      //name of the GUI parameter
+            string value;     //serialized value of the GUI parameter
+        };
+
+    private:
+        //ATTRIBUTES
+        ofFile logFile;                  //log file written while recording
+        ofParameterGroup parameters;     //GUI parameters whose changes are recorded and replayed
+        bool recording;                  //if true, the events are written in 'logFile'
+        bool replaying;                  //if true, the events are read from 'events'
+        bool dispatching;                //if true, the events sent to ofApp come from the log and not from the user
+
+        vector<InputEvent> events;       //events loaded from the log file
+        size_t nextEvent;                //index of the next event to dispatch
+        uint64_t endFrame;               //frame in which the recorded session ended
+
+        //frame report
+        vector<float> frameTimes;        //duration of each frame in milliseconds
+        uint64_t lastFrameMicros;        //system time of the previous frame
+        uint64_t memoryStart;            //resident memory at the first frame
+        uint64_t memoryPeak;             //highest resident memory sampled
+        uint64_t memoryEnd;              //resident memory at the last sample
+
+        void onParameterChanged(ofAbstractParameter & parameter);   //writes a GUI parameter change in the log
+        void writeEvent(const InputEvent & event);                  //writes an event as a line of the log
+
+    public:
+        //INTERFACE
+        InputRecorder();    //InputRecorder class constructor
+        ~InputRecorder();   //InputRecorder class destructor, it closes the log file
+
+        bool startRecording(string path, ofParameterGroup & group);   //opens the log and listens to 'group' changes
+        bool startReplay(string path, ofParameterGroup & group);      //loads the events of the log
+        void stop();                                                  //writes the end of the session and closes the log
+
+        //GETTER
+        bool isRecording();
+        bool isReplaying();
+        bool isDispatching();
+        bool isReplayOver(uint64_t frame);   //true when the replay has reached the last recorded frame
+
+        //RECORDING
+        void recordMouseMoved(int x, int y);
+        void recordMouseReleased(int x, int y, int button);
+        void recordMouseScrolled(int x, int y, float scrollY);
+        void recordKeyReleased(int key);
+
+        //REPLAY
+        bool popEvent(uint64_t frame, InputEvent & event);   //returns the next event received before or during 'frame'
+        void applyParameter(const InputEvent & event);       //sets the recorded value of a GUI parameter
+        void setDispatching(bool b);
+
+        //REPORT
+        void sampleFrame(uint64_t frame);   //measures the duration of the last frame, memory is sampled periodically
+        void writeReport(string path);      //writes frame time and memory statistics of the run
+
+        static bool readWindowSize(string path, int & width, int & height);   //window size stored in the log header
+};
@@ -0,0 +1,188 @@
+/*
+ JobSystem.cpp
+ OscarUniverse
+
+ JobSystem class: pool of worker threads with one task queue each. A parallel loop is split in chunks that are spread
+ over the queues; idle threads steal chunks from the other queues, so the load stays balanced across the cores
+ */
+
+#include "JobSystem.h"
+#include "AllocationTracker.h"
+
+
+//--------------------------------------------------------------
+JobSystem::JobSystem() {
+    running = false;
+    queuedTasks = 0;
+    nextQueue = 0;
+    queues.push_back(unique_ptr<Queue>(new Queue()));   //queue of the calling thread, used also without workers
+}
+
+
+//--------------------------------------------------------------
+JobSystem::~JobSystem() {
+    stop();
+}
+
+
+//--------------------------------------------------------------
+void JobSystem::setup(int threads) {
+    stop();
+
+    if(threads < 0) {
+        threads = max(0, (int)std::thread::hardware_concurrency() - 1);
+    }
+
+    queues.clear();
+    for(int i = 0; i <= threads; i++) {
+        queues.push_back(unique_ptr<Queue>(new Queue()));
+    }
+
+    running = true;
+    for(int i = 1; i <= threads; i++) {
+        workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+    }
+}
+
+
+//--------------------------------------------------------------
+void JobSystem::stop() {
+    {
+        lock_guard<std::mutex> lock(sleepMutex);
+        running = false;
+    }
+    wakeUp.notify_all();
+
+    for(auto & worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+
+//--------------------------------------------------------------
+void JobSystem::parallelFor(size_t count, size_t chunkSize, const Job & job) {
+    if(count == 0) {
+        return;
+    }
+
+    chunkSize = max((size_t)1, chunkSize);
+    size_t chunks = (count + chunkSize - 1) / chunkSize;
+
+    //small loops are not worth the synchronization; the chunks are still run one by one, the callers index their
+    //per-chunk results by begin / chunkSize
+    if(chunks == 1 || workers.empty()) {
+        for(size_t begin = 0; begin < count; begin += chunkSize) {
+            job(begin, min(begin + chunkSize, count));
+        }
+        return;
+    }
+
+    std::atomic<size_t> pending(chunks);
+    {
+        lock_guard<std::mutex> lock(sleepMutex);
+        queuedTasks += chunks;
+    }
+
+    //chunks are spread over all queues, a full queue runs the chunk immediately
+    for(size_t c = 0; c < chunks; c++) {
+        Task task;
+        task.job = &job;
+        task.begin = c * chunkSize;
+        task.end = min(count, task.begin + chunkSize);
+        task.pending = &pending;
+
+        if(!push(nextQueue, task)) {
+            queuedTasks--;
+            run(task);
+        }
+        nextQueue = (nextQueue + 1) % queues.size();
+    }
+    wakeUp.notify_all();
+
+    //the calling thread works until every chunk is completed, also the ones taken by other threads
+    Task task;
+    while(pending.load(std::memory_order_acquire) > 0) {
+        if(pop(0, task) || steal(0, task)) {
+            run(task);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+bool JobSystem::push(size_t queue, const Task & task) {
+    Queue & q = *queues[queue];
+    lock_guard<std::mutex> lock(q.mutex);
+    if(q.count == Queue::CAPACITY) {
+        return false;
+    }
+    q.tasks[(q.head + q.count) % Queue::CAPACITY] = task;
+    q.count++;
+    return true;
+}
+
+
+//--------------------------------------------------------------
+bool JobSystem::pop(size_t queue, Task & task) {
+    Queue & q = *queues[queue];
+    lock_guard<std::mutex> lock(q.mutex);
+    if(q.count == 0) {
+        return false;
+    }
+    task = q.tasks[q.head];
+    q.head = (q.head + 1) % Queue::CAPACITY;
+    q.count--;
+    queuedTasks--;
+    return true;
+}
+
+
+//--------------------------------------------------------------
+bool JobSystem::steal(size_t thief, Task & task) {
+    for(size_t i = 1; i < queues.size(); i++) {
+        Queue & q = *queues[(thief + i) % queues.size()];
+        lock_guard<std::mutex> lock(q.mutex);
+        if(q.count > 0) {
+            q.count--;
+            task = q.tasks[(q.head + q.count) % Queue::CAPACITY];
+            queuedTasks--;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+//--------------------------------------------------------------
+void JobSystem::run(Task & task) {
+    (*task.job)(task.begin, task.end);
+    task.pending -> fetch_sub(1, std::memory_order_release);
+}
+
+
+//--------------------------------------------------------------
+void JobSystem::workerLoop(size_t index) {
+    Task task;
+    while(running) {
+        if(pop(index, task) || steal(index, task)) {
+            AllocationTracker::trackThread(true);   //a chunk of the frame stages is part of the frame
+            run(task);
+            AllocationTracker::trackThread(false);
+            continue;
+        }
+
+        //no work left: sleep until new tasks are pushed
+        unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this] { return !running || queuedTasks > 0; });
+    }
+}
+
+
+//GETTER
+//--------------------------------------------------------------
+int JobSystem::getNumThreads() {
+    return workers.size() + 1;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ofMain.h"   //includes the Header file of OpenFrameworks
+#include <atomic>
+#include <condition_variable>
+
+class JobSystem {
+
+    public:
+        typedef std::function<void(size_t begin, size_t end)> Job;   //job executed on the range [begin, end)
+
+    private:
+        //a chunk of a parallel loop
+        struct Task {
+            const Job * job;                 //job to execute, it is owned by the caller of parallelFor
+            size_t begin;                    //first index of the chunk
+            size_t end;                      //index after the last one of the chunk
+            std::atomic<size_t> * pending;   //chunks of the loop not yet completed
+        };
+
+        //fixed size ring of tasks, the owner takes from the front and the thieves from the back
+        struct Queue {
+            static const size_t CAPACITY = 1024;
+            std::mutex mutex;
+            Task tasks[CAPACITY];
+            size_t head = 0;   //index of the first task
+            size_t count = 0;  //number of tasks in the queue
+        };
+
+        //ATTRIBUTES
+        vector<unique_ptr<Queue>> queues;   //one queue for each worker, queue 0 belongs to the calling thread
+        vector<std::thread> workers;        //worker threads
+        std::atomic<bool> running;          //if false, the workers exit
+        std::atomic<int> queuedTasks;       //tasks pushed and not yet taken by any thread
+        std::mutex sleepMutex;              //protects the sleep of idle workers
+        std::condition_variable wakeUp;     //wakes up idle workers when new tasks are pushed
+        size_t nextQueue;                   //queue that receives the next chunk
+
+        bool push(size_t queue, const Task & task);   //returns false if the queue is full
+        bool pop(size_t queue, Task & task);          //takes a task from the front of 'queue'
+        bool steal(size_t thief, Task & task);        //takes a task from the back of another queue
+        void run(Task & task);                        //executes a task and signals its completion
+        void workerLoop(size_t index);                //body of each worker thread
+
+    public:
+        //INTERFACE
+        JobSystem();    //JobSystem class constructor
+        ~JobSystem();   //JobSystem class destructor, it stops the workers
+
+        void setup(int threads = -1);   //starts 'threads' workers, by default one for each core except the calling one
+        void stop();                    //stops and joins the workers
+
+        //splits [0, count) in chunks of 'chunkSize' indices and runs 'job' on them in parallel,
+        //the calling thread takes part in the work and the method returns when all chunks are completed
+        void parallelFor(size_t count, size_t chunkSize, const Job & job);
+
+        //GETTER
+        int getNumThreads();   //worker threads plus the calling thread
+};
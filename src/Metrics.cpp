@@ -0,0 +1,135 @@
+/*
+ Metrics.cpp
+ OscarUniverse
+
+ Metrics class: lock-free counters about frames, views and media playback. The render thread only performs relaxed
+ atomic writes, so the metrics server can read them at any time without touching the render loop
+ */
+
+#include "Metrics.h"
+#include "ProcessStats.h"
+
+//upper bounds of the histogram buckets in milliseconds (16.7 ms is one frame at 60 fps)
+static const double BUCKET_BOUNDS[Metrics::Histogram::BUCKETS] = {1, 2, 4, 8, 12, 16.7, 20, 25, 33.3, 50, 100, 250};
+
+
+//--------------------------------------------------------------
+Metrics::Histogram::Histogram() {
+    for(int i = 0; i <= BUCKETS; i++) {
+        counts[i] = 0;
+    }
+    sumMicros = 0;
+}
+
+
+//--------------------------------------------------------------
+void Metrics::Histogram::observe(uint64_t micros) {
+    double ms = micros / 1000.0;
+
+    int bucket = 0;
+    while(bucket < BUCKETS && ms > BUCKET_BOUNDS[bucket]) {
+        bucket++;
+    }
+
+    counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    sumMicros.fetch_add(micros, std::memory_order_relaxed);
+}
+
+
+//--------------------------------------------------------------
+void Metrics::Histogram::write(ostream & out, const string & name, const string & help) const {
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " histogram\n";
+
+    //Prometheus buckets are cumulative and their bounds are in seconds
+    uint64_t cumulative = 0;
+    for(int i = 0; i < BUCKETS; i++) {
+        cumulative += counts[i].load(std::memory_order_relaxed);
+        out << name << "_bucket{le=\"" << BUCKET_BOUNDS[i] / 1000.0 << "\"} " << cumulative << "\n";
+    }
+    cumulative += counts[BUCKETS].load(std::memory_order_relaxed);
+    out << name << "_bucket{le=\"+Inf\"} " << cumulative << "\n";
+    out << name << "_sum " << sumMicros.load(std::memory_order_relaxed) / 1000000.0 << "\n";
+    out << name << "_count " << cumulative << "\n";
+}
+
+
+//--------------------------------------------------------------
+Metrics::Metrics() {
+    view = UNIVERSE;
+    selectedMovie = -1;
+    trailerDecodedFrames = 0;
+    trailerDroppedFrames = 0;
+    audioUnderruns = 0;
+    liveTextures = 0;
+    liveBuffers = 0;
+    stateCallsIssued = 0;
+    stateCallsSuppressed = 0;
+}
+
+
+//--------------------------------------------------------------
+void Metrics::setMovieIds(const vector<string> & ids) {
+    movieIds = ids;
+}
+
+
+//--------------------------------------------------------------
+string Metrics::toPrometheus() const {
+    ostringstream out;
+
+    frameTime.write(out, "oscar_frame_seconds", "Time between the beginning of two frames.");
+    updateTime.write(out, "oscar_update_seconds", "Time spent in ofApp::update.");
+    drawTime.write(out, "oscar_draw_seconds", "Time spent in ofApp::draw.");
+    inputLatency.write(out, "oscar_input_latency_seconds",
+                       "Time an input command waits in the simulation queue, from ofApp handling the event to the step "
+                       "applying it; the time before the render thread reads the event is not included.");
+
+    out << "# HELP oscar_view Current view: 0 universe, 1 inside a movie box.\n";
+    out << "# TYPE oscar_view gauge\n";
+    out << "oscar_view " << view.load(std::memory_order_relaxed) << "\n";
+
+    //the ID of the selected movie is the label of a single info series, the other movies are not listed so the number
+    //of series does not grow with the catalog
+    int selected = selectedMovie.load(std::memory_order_relaxed);
+    out << "# HELP oscar_selected_movie Movie box currently selected, no series when none is selected.\n";
+    out << "# TYPE oscar_selected_movie gauge\n";
+    if(selected >= 0 && selected < (int)movieIds.size()) {
+        out << "oscar_selected_movie{id=\"" << movieIds[selected] << "\"} 1\n";
+    }
+
+    out << "# HELP oscar_trailer_decoded_frames_total New trailer frames received from the decoder.\n";
+    out << "# TYPE oscar_trailer_decoded_frames_total counter\n";
+    out << "oscar_trailer_decoded_frames_total " << trailerDecodedFrames.load(std::memory_order_relaxed) << "\n";
+
+    out << "# HELP oscar_trailer_dropped_frames_total Trailer frames skipped by the decoder.\n";
+    out << "# TYPE oscar_trailer_dropped_frames_total counter\n";
+    out << "oscar_trailer_dropped_frames_total " << trailerDroppedFrames.load(std::memory_order_relaxed) << "\n";
+
+    out << "# HELP oscar_audio_underruns_total Times the soundtrack stopped advancing while playing.\n";
+    out << "# TYPE oscar_audio_underruns_total counter\n";
+    out << "oscar_audio_underruns_total " << audioUnderruns.load(std::memory_order_relaxed) << "\n";
+
+    out << "# HELP oscar_gl_textures GL textures allocated by the application.\n";
+    out << "# TYPE oscar_gl_textures gauge\n";
+    out << "oscar_gl_textures " << liveTextures.load(std::memory_order_relaxed) << "\n";
+
+    out << "# HELP oscar_gl_buffers GL buffers allocated by the application.\n";
+    out << "# TYPE oscar_gl_buffers gauge\n";
+    out << "oscar_gl_buffers " << liveBuffers.load(std::memory_order_relaxed) << "\n";
+
+    out << "# HELP oscar_gl_state_calls_issued_total GL state calls sent to the driver.\n";
+    out << "# TYPE oscar_gl_state_calls_issued_total counter\n";
+    out << "oscar_gl_state_calls_issued_total " << stateCallsIssued.load(std::memory_order_relaxed) << "\n";
+
+    out << "# HELP oscar_gl_state_calls_suppressed_total GL state calls skipped because they would change nothing.\n";
+    out << "# TYPE oscar_gl_state_calls_suppressed_total counter\n";
+    out << "oscar_gl_state_calls_suppressed_total " << stateCallsSuppressed.load(std::memory_order_relaxed) << "\n";
+
+    //memory is read directly by the server thread
+    out << "# HELP oscar_resident_memory_bytes Resident set size of the process.\n";
+    out << "# TYPE oscar_resident_memory_bytes gauge\n";
+    out << "oscar_resident_memory_bytes " << ProcessStats::getResidentMemory() << "\n";
+
+    return out.str();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ofMain.h"   //includes the Header file of OpenFrameworks
+#include <atomic>
+
+class Metrics {
+
+    public:
+        //durations histogram in milliseconds, written from the render and simulation threads and read from the metrics
+        //server thread
+        class Histogram {
+            public:
+                static const int BUCKETS = 12;   //number of finite buckets, the last one is +Inf
+
+            private:
+                std::atomic<uint64_t> counts[BUCKETS + 1];   //observations in each bucket (not cumulative)
+                std::atomic<uint64_t> sumMicros;             //sum of all observations in microseconds
+
+            public:
+                Histogram();
+                void observe(uint64_t micros);   //adds an observation
+                void write(ostream & out, const string & name, const string & help) const;   //Prometheus text format
+        };
+
+        //view currently shown by the render thread
+        enum View {
+            UNIVERSE = 0,
+            INSIDE_BOX = 1
+        };
+
+        //ATTRIBUTES
+        Histogram frameTime;    //time between the beginning of two frames
+        Histogram updateTime;   //time spent in ofApp::update
+        Histogram drawTime;     //time spent in ofApp::draw
+        Histogram inputLatency; //time an input command waits in the simulation queue before the step applying it
+
+        std::atomic<int> view;                        //one of View values
+        std::atomic<int> selectedMovie;               //index of the selected movie box, -1 if none
+        std::atomic<uint64_t> trailerDecodedFrames;   //new trailer frames received from the decoder
+        std::atomic<uint64_t> trailerDroppedFrames;   //trailer frames skipped by the decoder
+        std::atomic<uint64_t> audioUnderruns;         //times the soundtrack stopped advancing while playing
+        std::atomic<int> liveTextures;                //GL textures allocated by the application
+        std::atomic<int> liveBuffers;                 //GL buffers allocated by the application
+        std::atomic<uint64_t> stateCallsIssued;       //GL state calls sent to the driver
+        std::atomic<uint64_t> stateCallsSuppressed;   //GL state calls skipped because they would change nothing
+
+    private:
+        vector<string> movieIds;   //ID of each movie box, it is written once before the server starts
+
+    public:
+        //INTERFACE
+        Metrics();   //Metrics class constructor
+
+        void setMovieIds(const vector<string> & ids);   //it must be called before the server thread starts
+        string toPrometheus() const;                    //all metrics in Prometheus text exposition format
+};
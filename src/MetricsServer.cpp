@@ -0,0 +1,163 @@
+/*
+ MetricsServer.cpp
+ OscarUniverse
+
+ MetricsServer class: minimal HTTP endpoint on localhost that serves the metrics in Prometheus text format.
+ It runs on its own thread and only reads the lock-free counters of the Metrics class, so scraping never blocks the render loop
+ */
+
+#include "MetricsServer.h"
+
+#ifndef TARGET_WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+//a closed connection must not kill the process with SIGPIPE
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static const int SEND_FLAGS = 0;
+#endif
+
+
+//--------------------------------------------------------------
+MetricsServer::MetricsServer() {
+    metrics = NULL;
+    listenSocket = -1;
+    port = 0;
+}
+
+
+//--------------------------------------------------------------
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+
+//--------------------------------------------------------------
+bool MetricsServer::start(const Metrics * m, int p) {
+#ifdef TARGET_WIN32
+    ofLogError("MetricsServer") << "the metrics endpoint is not available on Windows";
+    return false;
+#else
+    metrics = m;
+    port = p;
+
+    listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if(listenSocket < 0) {
+        ofLogError("MetricsServer") << "unable to create socket";
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#ifdef SO_NOSIGPIPE
+    setsockopt(listenSocket, SOL_SOCKET, SO_NOSIGPIPE, &reuse, sizeof(reuse));
+#endif
+
+    //only local scrapers can connect
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+
+    if(::bind(listenSocket, (sockaddr *)&address, sizeof(address)) < 0 || listen(listenSocket, 4) < 0) {
+        ofLogError("MetricsServer") << "unable to listen on 127.0.0.1:" << port;
+        close(listenSocket);
+        listenSocket = -1;
+        return false;
+    }
+
+    startThread();
+    ofLogNotice("MetricsServer") << "serving metrics on http://127.0.0.1:" << port << "/metrics";
+    return true;
+#endif
+}
+
+
+//--------------------------------------------------------------
+void MetricsServer::stop() {
+#ifndef TARGET_WIN32
+    if(isThreadRunning()) {
+        waitForThread(true);   //the accept loop wakes up at least every 200 ms
+    }
+    if(listenSocket >= 0) {
+        close(listenSocket);
+        listenSocket = -1;
+    }
+#endif
+}
+
+
+//--------------------------------------------------------------
+void MetricsServer::threadedFunction() {
+#ifndef TARGET_WIN32
+    while(isThreadRunning()) {
+        //poll with a timeout, so that the thread can be stopped without closing the socket under accept()
+        pollfd listening;
+        listening.fd = listenSocket;
+        listening.events = POLLIN;
+        listening.revents = 0;
+        if(poll(&listening, 1, 200) <= 0) {
+            continue;
+        }
+
+        int client = accept(listenSocket, NULL, NULL);
+        if(client >= 0) {
+            serveClient(client);
+            close(client);
+        }
+    }
+#endif
+}
+
+
+//--------------------------------------------------------------
+void MetricsServer::serveClient(int client) {
+#ifndef TARGET_WIN32
+    //a slow client must not keep the thread busy
+    timeval timeout;
+    timeout.tv_sec = 1;
+    timeout.tv_usec = 0;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    //only the request line is needed
+    char request[1024];
+    ssize_t received = recv(client, request, sizeof(request) - 1, 0);
+    if(received <= 0) {
+        return;
+    }
+    request[received] = '\0';
+    string requestLine(request);
+
+    string status;
+    string body;
+    if(requestLine.compare(0, 13, "GET /metrics ") == 0 || requestLine.compare(0, 6, "GET / ") == 0) {
+        status = "200 OK";
+        body = metrics -> toPrometheus();
+    } else {
+        status = "404 Not Found";
+        body = "not found\n";
+    }
+
+    string response = "HTTP/1.0 " + status + "\r\n"
+                      "Content-Type: text/plain; version=0.0.4\r\n"
+                      "Content-Length: " + ofToString(body.size()) + "\r\n"
+                      "Connection: close\r\n\r\n" + body;
+
+    size_t sent = 0;
+    while(sent < response.size()) {
+        ssize_t n = send(client, response.data() + sent, response.size() - sent, SEND_FLAGS);
+        if(n <= 0) {
+            return;
+        }
+        sent += n;
+    }
+#endif
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "ofMain.h"   //includes the Header file of OpenFrameworks
+#include "Metrics.h"
+
+class MetricsServer : public ofThread {
+
+    private:
+        //ATTRIBUTES
+        const Metrics * metrics;   //metrics to serve, they are owned by ofApp
+        int listenSocket;          //socket accepting connections on localhost
+        int port;                  //port of the HTTP endpoint
+
+        void threadedFunction();                //accepts connections until the thread is stopped
+        void serveClient(int client);           //answers a single HTTP request
+
+    public:
+        //INTERFACE
+        MetricsServer();    //MetricsServer class constructor
+        ~MetricsServer();   //MetricsServer class destructor, it stops the thread and closes the socket
+
+        bool start(const Metrics * m, int p);   //binds 127.0.0.1:'p' and starts serving 'm' in background
+        void stop();                            //stops the background thread
+};
@@ -0,0 +1,301 @@
+/*
+ MovieStore.cpp
+ OscarUniverse
+
+ MovieStore class: structure of arrays with all the movies of the universe. The state used every frame (positions and
+ rotations) is kept in contiguous arrays, while the heavy assets (textures, trailer, soundtrack) are kept on the side
+ in FilmBox objects reached through a handle. Movies are identified by a stable MovieId. The FilmBox objects are
+ pooled with their textures: the images of a movie entering a ring are decoded on a loader thread and uploaded into the
+ textures of a recycled box, so scrolling neither allocates GL storage nor decodes on the render thread
+ */
+
+#include "MovieStore.h"
+#include <cassert>
+
+
+//--------------------------------------------------------------
+MovieStore::MovieStore() {
+    playIconTexture = NULL;
+    pendingLoads = 0;
+    isSynchronous = false;
+    loader.store = this;
+}
+
+
+//--------------------------------------------------------------
+MovieStore::~MovieStore() {
+    loadRequests.close();
+    decodedLoads.close();
+    if(loader.isThreadRunning()) {
+        loader.waitForThread(true);
+    }
+}
+
+
+//--------------------------------------------------------------
+MovieStore::MovieId MovieStore::add(string idMovie, int galaxy, int ringSlot) {
+    MovieId id = ids.size();
+
+    //hot data
+    worldPositions.push_back(ofPoint(0, 0, 0));
+    screenPositions.push_back(ofPoint(0, 0, 0));
+    rotations.push_back(0);
+    galaxies.push_back(galaxy);
+    ringSlots.push_back(ringSlot);
+
+    //cold data, the assets are loaded only when the movie is needed
+    ids.push_back(idMovie);
+    assetSlots.push_back(-1);
+    assetsReady.push_back(0);
+
+    return id;
+}
+
+
+//--------------------------------------------------------------
+size_t MovieStore::size() const {
+    return ids.size();
+}
+
+
+//HOT DATA VIEWS
+//--------------------------------------------------------------
+vector<ofPoint> & MovieStore::getWorldPositions() {
+    return worldPositions;
+}
+
+
+//--------------------------------------------------------------
+vector<ofPoint> & MovieStore::getScreenPositions() {
+    return screenPositions;
+}
+
+
+//--------------------------------------------------------------
+const ofPoint & MovieStore::getWorldPosition(MovieId id) const {
+    return worldPositions[id];
+}
+
+
+//--------------------------------------------------------------
+int MovieStore::getRotation(MovieId id) const {
+    return rotations[id];
+}
+
+
+//--------------------------------------------------------------
+void MovieStore::setRotation(MovieId id, int n) {
+    rotations[id] = n;
+}
+
+
+//--------------------------------------------------------------
+int MovieStore::getGalaxy(MovieId id) const {
+    return galaxies[id];
+}
+
+
+//--------------------------------------------------------------
+int MovieStore::getRingSlot(MovieId id) const {
+    return ringSlots[id];
+}
+
+
+//COLD DATA VIEWS
+//--------------------------------------------------------------
+FilmBox & MovieStore::getAssets(MovieId id) {
+    assert(isResident(id) && "the assets of a movie are reached only while they are loaded");
+    return *assets[assetSlots[id]];
+}
+
+
+//--------------------------------------------------------------
+const string & MovieStore::getId(MovieId id) const {
+    return ids[id];
+}
+
+
+//--------------------------------------------------------------
+const vector<string> & MovieStore::getIds() const {
+    return ids;
+}
+
+
+//--------------------------------------------------------------
+void MovieStore::setPlayIconTexture(ofTexture * texture) {
+    playIconTexture = texture;
+    for(auto & asset : assets) {
+        asset -> setPlayIconTexture(texture);
+    }
+}
+
+
+//ASSET PAGING
+//--------------------------------------------------------------
+void MovieStore::acquireAssets(MovieId id) {
+    if(assetSlots[id] >= 0) {
+        return;
+    }
+
+    //a released slot is reused before the pool grows
+    int slot;
+    if(!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = assets.size();
+        assets.push_back(unique_ptr<FilmBox>(new FilmBox()));
+        assets.back() -> setPlayIconTexture(playIconTexture);
+    }
+
+    assetSlots[id] = slot;
+    assetsReady[id] = 0;
+
+    //deterministic runs load the images now, otherwise the loader thread decodes them and update uploads them
+    if(isSynchronous) {
+        assets[slot] -> setId(ids[id]);
+        assetsReady[id] = 1;
+        return;
+    }
+    if(!loader.isThreadRunning()) {
+        loader.startThread();
+    }
+    Load load;
+    load.id = id;
+    load.idMovie = ids[id];
+    load.slot = slot;
+    loadRequests.send(std::move(load));
+    pendingLoads++;
+}
+
+
+//--------------------------------------------------------------
+void MovieStore::releaseAssets(MovieId id) {
+    if(assetSlots[id] < 0) {
+        return;
+    }
+
+    //the textures stay allocated for the next movie of the slot, a load still in flight is discarded when it arrives
+    assets[assetSlots[id]] -> closeMedia();
+    freeSlots.push_back(assetSlots[id]);
+    assetSlots[id] = -1;
+    assetsReady[id] = 0;
+}
+
+
+//--------------------------------------------------------------
+void MovieStore::update(int uploadBudget) {
+    Load load;
+    int uploads = 0;
+    while((uploadBudget < 0 || uploads < uploadBudget) && decodedLoads.tryReceive(load)) {
+        pendingLoads--;
+        if(assetSlots[load.id] == load.slot && !assetsReady[load.id]) {
+            finishLoad(load);
+            uploads++;
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+void MovieStore::waitForLoads() {
+    Load load;
+    while(pendingLoads > 0 && decodedLoads.receive(load)) {
+        pendingLoads--;
+        if(assetSlots[load.id] == load.slot && !assetsReady[load.id]) {
+            finishLoad(load);
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+void MovieStore::finishLoad(const Load & load) {
+    assets[load.slot] -> setImages(load.idMovie, load.images);
+    assetsReady[load.id] = 1;
+}
+
+
+//--------------------------------------------------------------
+void MovieStore::setSynchronous(bool b) {
+    waitForLoads();   //the loads already queued are completed before the mode changes
+    isSynchronous = b;
+}
+
+
+//--------------------------------------------------------------
+void MovieStore::Loader::threadedFunction() {
+    //decoding (or reading the texture cache) is the slow part of a load, it never runs on the render thread
+    Load load;
+    while(store -> loadRequests.receive(load)) {
+        FilmBox::decodeImages(load.idMovie, load.images);
+        store -> decodedLoads.send(std::move(load));
+    }
+}
+
+
+//--------------------------------------------------------------
+bool MovieStore::isAcquired(MovieId id) const {
+    return assetSlots[id] >= 0;
+}
+
+
+//--------------------------------------------------------------
+bool MovieStore::isResident(MovieId id) const {
+    return assetSlots[id] >= 0 && assetsReady[id];
+}
+
+
+//--------------------------------------------------------------
+bool MovieStore::isLoading() const {
+    return pendingLoads > 0;
+}
+
+
+//--------------------------------------------------------------
+int MovieStore::getResidentCount() const {
+    return assets.size() - freeSlots.size();
+}
+
+
+//METHODS
+//--------------------------------------------------------------
+bool MovieStore::intersects(MovieId id, const glm::vec3 & origin, const glm::vec3 & direction, float & distance) const {
+    //the axis aligned bounds of the movie box are used, no mesh is needed
+    glm::vec3 halfSize = glm::vec3(FilmBox::getDimensionBox()) * 0.5f;
+    glm::vec3 center = worldPositions[id];
+    return intersectsBounds(origin, direction, center - halfSize, center + halfSize, distance);
+}
+
+
+//--------------------------------------------------------------
+bool MovieStore::intersectsBounds(const glm::vec3 & origin, const glm::vec3 & direction,
+                                  const glm::vec3 & minBounds, const glm::vec3 & maxBounds, float & distance) {
+    //slab test between the ray and the box
+    float tNear = -numeric_limits<float>::max();
+    float tFar = numeric_limits<float>::max();
+
+    for(int axis = 0; axis < 3; axis++) {
+        if(abs(direction[axis]) < 1e-6f) {
+            //the ray is parallel to the slab, it must start inside it
+            if(origin[axis] < minBounds[axis] || origin[axis] > maxBounds[axis]) {
+                return false;
+            }
+        } else {
+            float t1 = (minBounds[axis] - origin[axis]) / direction[axis];
+            float t2 = (maxBounds[axis] - origin[axis]) / direction[axis];
+            tNear = max(tNear, min(t1, t2));
+            tFar = min(tFar, max(t1, t2));
+            if(tNear > tFar) {
+                return false;
+            }
+        }
+    }
+
+    if(tFar < 0.f) {   //the box is behind the ray
+        return false;
+    }
+
+    distance = max(tNear, 0.f);
+    return true;
+}
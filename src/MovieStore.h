@@ -0,0 +1,90 @@
+#pragma once
+
+#include "ofMain.h"   //includes the Header file of OpenFrameworks
+#include "FilmBox.h"
+
+class MovieStore {
+
+    public:
+        typedef int MovieId;                  //stable identifier of a movie, it never changes while the store exists
+        static const MovieId NO_MOVIE = -1;   //identifier used when no movie is selected
+
+    private:
+        //images of a movie decoded by the loader thread for a slot of the pool
+        struct Load {
+            MovieId id;                //movie whose assets are loaded
+            string idMovie;            //folder of the movie, copied so the loader thread never reads the store
+            int slot;                  //slot of 'assets' that receives the images
+            FilmBox::Images images;    //decoded images, filled by the loader thread
+        };
+
+        //worker thread decoding the images of the movies entering a ring, the render thread only uploads them
+        class Loader : public ofThread {
+            public:
+                MovieStore * store;
+                void threadedFunction();
+        };
+
+        //HOT ATTRIBUTES (read or written every frame, one contiguous array for each attribute)
+        vector<ofPoint> worldPositions;    //movie box positions in world coordinates
+        vector<ofPoint> screenPositions;   //movie box positions in screen coordinates
+        vector<int> rotations;             //angle rotation of each movie box
+        vector<int> galaxies;              //cluster of each movie
+        vector<int> ringSlots;             //position of each movie on the ring of its cluster
+
+        //COLD ATTRIBUTES (assets, used only when a movie box is drawn or selected)
+        vector<string> ids;                     //movie IDs, they are also the names of the asset folders
+        vector<int> assetSlots;                 //handle of the assets of each movie in 'assets', -1 if not acquired
+        vector<uint8_t> assetsReady;            //1 when the images of the movie are uploaded in its slot
+        vector<unique_ptr<FilmBox>> assets;     //pool of textures, trailers and soundtracks
+        vector<int> freeSlots;                  //slots of 'assets' not used by any movie, they are recycled
+        ofTexture * playIconTexture;            //play icon shared by all movie boxes
+
+        //LOADING
+        ofThreadChannel<Load> loadRequests;     //movies waiting for the loader thread
+        ofThreadChannel<Load> decodedLoads;     //images decoded and waiting for their upload
+        Loader loader;
+        int pendingLoads;                       //requests sent and not yet received back
+        bool isSynchronous;                     //if true, the images are decoded and uploaded in acquireAssets
+
+        void finishLoad(const Load & load);     //uploads the images of a load if its movie still owns the slot
+
+    public:
+        //INTERFACE
+        MovieStore();    //MovieStore class constructor
+        ~MovieStore();   //MovieStore class destructor, it stops the loader thread
+
+        MovieId add(string idMovie, int galaxy, int ringSlot);   //adds a movie without loading its assets
+        size_t size() const;
+
+        //HOT DATA VIEWS
+        vector<ofPoint> & getWorldPositions();
+        vector<ofPoint> & getScreenPositions();
+        const ofPoint & getWorldPosition(MovieId id) const;
+        int getRotation(MovieId id) const;
+        void setRotation(MovieId id, int n);
+        int getGalaxy(MovieId id) const;
+        int getRingSlot(MovieId id) const;
+
+        //COLD DATA VIEWS
+        FilmBox & getAssets(MovieId id);   //the movie must be resident
+        const string & getId(MovieId id) const;
+        const vector<string> & getIds() const;
+        void setPlayIconTexture(ofTexture * texture);
+
+        //ASSET PAGING
+        void acquireAssets(MovieId id);    //takes a slot of the pool for a movie and queues the decoding of its images
+        void releaseAssets(MovieId id);    //gives the slot of a movie back to the pool, its textures are kept for reuse
+        void update(int uploadBudget);     //uploads the images already decoded, a negative budget uploads all of them
+        void waitForLoads();               //waits for all queued images and uploads them
+        void setSynchronous(bool b);       //if true, the images are loaded on the calling thread (deterministic runs)
+        bool isAcquired(MovieId id) const; //true from acquireAssets to releaseAssets, also while the images are decoded
+        bool isResident(MovieId id) const; //true when the images are uploaded and the box can be drawn
+        bool isLoading() const;            //true while some images are queued or being decoded
+        int getResidentCount() const;
+
+        //METHODS
+        bool intersects(MovieId id, const glm::vec3 & origin, const glm::vec3 & direction, float & distance) const;
+        static bool intersectsBounds(const glm::vec3 & origin, const glm::vec3 & direction,
+                                     const glm::vec3 & minBounds, const glm::vec3 & maxBounds, float & distance);
+};
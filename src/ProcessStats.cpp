@@ -0,0 +1,179 @@
+/*
+ ProcessStats.cpp
+ OscarUniverse
+
+ ProcessStats class: reads resource usage of the running process from the operating system
+ */
+
+#include "ProcessStats.h"
+
+#if defined(TARGET_OSX)
+#include <mach/mach.h>
+#elif defined(TARGET_WIN32)
+#include <psapi.h>
+#else
+#include <unistd.h>
+#include <dirent.h>
+#endif
+
+//highest GL names probed so far, names released by the driver can be reused below the last generated one
+static GLuint textureScanLimit = 1;
+static GLuint bufferScanLimit = 1;
+
+//GL objects allocated by the application and not yet released
+static int allocatedTextures = 0;
+static int allocatedBuffers = 0;
+
+
+//--------------------------------------------------------------
+uint64_t ProcessStats::getResidentMemory() {
+#if defined(TARGET_OSX)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if(task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.resident_size;
+#elif defined(TARGET_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.WorkingSetSize;
+#else
+    //the second field of /proc/self/statm is the number of resident pages
+    FILE * statm = fopen("/proc/self/statm", "r");
+    if(statm == NULL) {
+        return 0;
+    }
+    unsigned long long totalPages = 0;
+    unsigned long long residentPages = 0;
+    int fields = fscanf(statm, "%llu %llu", &totalPages, &residentPages);
+    fclose(statm);
+
+    if(fields != 2) {
+        return 0;
+    }
+    return residentPages * (uint64_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+
+//--------------------------------------------------------------
+int ProcessStats::getOpenFileDescriptors() {
+#if defined(TARGET_WIN32)
+    DWORD handles = 0;
+    GetProcessHandleCount(GetCurrentProcess(), &handles);
+    return handles;
+#else
+    //each entry of the directory is an open descriptor
+#if defined(TARGET_OSX)
+    DIR * directory = opendir("/dev/fd");
+#else
+    DIR * directory = opendir("/proc/self/fd");
+#endif
+    if(directory == NULL) {
+        return 0;
+    }
+    int count = 0;
+    while(readdir(directory) != NULL) {
+        count++;
+    }
+    closedir(directory);
+    return max(0, count - 3);   //'.', '..' and the descriptor of the directory itself are not counted
+#endif
+}
+
+
+//--------------------------------------------------------------
+int ProcessStats::getThreadCount() {
+#if defined(TARGET_OSX)
+    thread_act_array_t threads;
+    mach_msg_type_number_t count = 0;
+    if(task_threads(mach_task_self(), &threads, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    for(mach_msg_type_number_t i = 0; i < count; i++) {
+        mach_port_deallocate(mach_task_self(), threads[i]);
+    }
+    vm_deallocate(mach_task_self(), (vm_address_t)threads, count * sizeof(thread_act_t));
+    return count;
+#elif defined(TARGET_WIN32)
+    return 0;
+#else
+    //the line 'Threads:' of /proc/self/status contains the number of threads
+    FILE * status = fopen("/proc/self/status", "r");
+    if(status == NULL) {
+        return 0;
+    }
+    char line[256];
+    int count = 0;
+    while(fgets(line, sizeof(line), status) != NULL) {
+        if(sscanf(line, "Threads: %d", &count) == 1) {
+            break;
+        }
+    }
+    fclose(status);
+    return count;
+#endif
+}
+
+
+//--------------------------------------------------------------
+int ProcessStats::getLiveTextures() {
+    //the name returned by glGenTextures is above the names in use, the names below are probed one by one
+    GLuint probe;
+    glGenTextures(1, &probe);
+    textureScanLimit = max(textureScanLimit, probe);
+
+    int count = 0;
+    for(GLuint name = 1; name < textureScanLimit; name++) {
+        if(name != probe && glIsTexture(name)) {
+            count++;
+        }
+    }
+    glDeleteTextures(1, &probe);
+    return count;
+}
+
+
+//--------------------------------------------------------------
+int ProcessStats::getLiveBuffers() {
+    //same strategy used for textures
+    GLuint probe;
+    glGenBuffers(1, &probe);
+    bufferScanLimit = max(bufferScanLimit, probe);
+
+    int count = 0;
+    for(GLuint name = 1; name < bufferScanLimit; name++) {
+        if(name != probe && glIsBuffer(name)) {
+            count++;
+        }
+    }
+    glDeleteBuffers(1, &probe);
+    return count;
+}
+
+
+//--------------------------------------------------------------
+void ProcessStats::addTextures(int count) {
+    allocatedTextures += count;
+}
+
+
+//--------------------------------------------------------------
+void ProcessStats::addBuffers(int count) {
+    allocatedBuffers += count;
+}
+
+
+//--------------------------------------------------------------
+int ProcessStats::getAllocatedTextures() {
+    return allocatedTextures;
+}
+
+
+//--------------------------------------------------------------
+int ProcessStats::getAllocatedBuffers() {
+    return allocatedBuffers;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "ofMain.h"   //includes the Header file of OpenFrameworks
+
+class ProcessStats {
+
+    public:
+        //INTERFACE
+        static uint64_t getResidentMemory();       //resident set size of the process in bytes (0 if it is not available)
+        static int getOpenFileDescriptors();       //number of open file descriptors (0 if it is not available)
+        static int getThreadCount();               //number of threads of the process, decoder threads included
+        static int getLiveTextures();              //number of GL textures alive, it must be called from the GL thread
+        static int getLiveBuffers();               //number of GL buffers alive, it must be called from the GL thread
+
+        //GL objects of the application, counted where it allocates and releases them so that no name is probed; the
+        //metrics read them at every frame, the soak test probes all names to find also the leaks of the libraries
+        static void addTextures(int count);        //called from the GL thread, 'count' is negative for released textures
+        static void addBuffers(int count);         //called from the GL thread, 'count' is negative for released buffers
+        static int getAllocatedTextures();
+        static int getAllocatedBuffers();
+};
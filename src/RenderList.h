@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ofMain.h"   //includes the Header file of OpenFrameworks
+#include "MovieStore.h"
+#include "GalaxyMap.h"
+
+//movie box to draw in the current frame
+struct RenderItem {
+    MovieStore::MovieId id;   //movie of the box
+    ofPoint position;         //box position in world coordinates
+    int rotation;             //angle rotation of the box
+};
+
+//result of the per-frame stages (layout, projection, culling and picking), the GL thread only reads it
+struct RenderList {
+    vector<RenderItem> items;      //movie boxes inside the camera frustum, in drawing order
+    MovieStore::MovieId hovered;   //movie box pointed by the mouse, NO_MOVIE if none
+    float hoveredDistance;         //distance of the hovered box from the ray origin
+    int hoveredGalaxy;             //collapsed cluster pointed by the mouse, -1 if none
+};
+
+//inputs and scratch arrays of the per-frame stages, allocated in the frame arena so the workers receive a single
+//pointer and the stages never touch the heap
+struct LayoutFrame {
+    const GalaxyMap::RingEntry * activeMovies;   //visible arcs of expanded clusters
+    size_t count;                                //number of active movies
+    glm::vec4 viewport;                          //viewport of the camera: x, y, width and height
+    glm::mat4 modelViewProjection;               //model view projection matrix of the camera
+    bool isVFlipped;                             //true if the camera is vertically flipped
+    glm::vec3 rayOrigin;                         //origin of the mouse ray
+    glm::vec3 rayDirection;                      //direction of the mouse ray
+    float startAngle;                            //scroll angle of the rings
+    float radius;                                //bounding sphere of a movie box
+    glm::vec4 planes[6];                         //frustum planes
+    uint8_t * visibility;                        //1 if the k-th active movie box is inside the camera frustum
+    float * hitDistances;                        //distance of the nearest box hit by the ray in each chunk
+    MovieStore::MovieId * hits;                  //nearest box hit by the ray in each chunk
+};
@@ -0,0 +1,245 @@
+/*
+ Simulation.cpp
+ OscarUniverse
+
+ Simulation class: the interaction and animation state (camera tween, rotation of the selected movie box, inertial
+ scrolling of the rings) is advanced at a fixed rate on its own thread. The render thread sends its input through a
+ lock-free queue and reads the latest state through a triple buffer, so a slow frame does not slow the animations down.
+ The input events are still read by the event loop of the render thread, so a slow frame delays them; once sent, a
+ command is applied within one step. Everything touching GL or the media players stays on the render thread
+ */
+
+#include "Simulation.h"
+
+//camera tween: fraction of the remaining distance covered at each step
+static const float CAMERA_TWEEN = 0.3f;
+
+//inertial scrolling of the ring: speed added by a wheel step (degrees per second) and speed kept after one second
+static const float SCROLL_IMPULSE = 60.f;
+static const float SCROLL_FRICTION = 0.05f;
+
+
+//--------------------------------------------------------------
+Simulation::Simulation() {
+    sequence = 0;
+    lockstep = true;
+    metrics = NULL;
+    start(glm::vec3(0, 0, 0), true, NULL);
+}
+
+
+//--------------------------------------------------------------
+Simulation::~Simulation() {
+    stop();
+}
+
+
+//--------------------------------------------------------------
+void Simulation::start(const glm::vec3 & cameraPosition, bool isLockstep, Metrics * m) {
+    stop();
+    lockstep = isLockstep;
+    metrics = m;
+
+    //the commands sent during the setup are replaced by the initial state
+    Command command;
+    while(commands.pop(command)) {}
+
+    state.tick = 0;
+    state.inputSequence = sequence;
+    state.cameraPosition = cameraPosition;
+    state.isCameraMoving = false;
+    state.boxRotation = 0;
+    state.isBoxRotating = false;
+    state.scrollAngle = 0.f;
+    state.isScrolling = false;
+    cameraTarget = cameraPosition;
+    rotationDirection = 1;
+    rotationStep = 0;
+    rotationSpeed = 1;
+    scrollSpeed = 0.f;
+
+    //the thread is not running yet, the initial state is published and taken on this thread
+    snapshots.getBack() = state;
+    snapshots.publish();
+    snapshots.consume();
+
+    if(!lockstep) {
+        startThread();
+    }
+}
+
+
+//--------------------------------------------------------------
+void Simulation::stop() {
+    if(isThreadRunning()) {
+        waitForThread(true);
+    }
+}
+
+
+//--------------------------------------------------------------
+void Simulation::update() {
+    if(lockstep) {
+        step(1.f / RATE);
+    }
+    snapshots.consume();
+}
+
+
+//--------------------------------------------------------------
+void Simulation::threadedFunction() {
+    const uint64_t stepMicros = 1000000 / RATE;
+    uint64_t next = ofGetSystemTimeMicros();
+
+    while(isThreadRunning()) {
+        step(1.f / RATE);
+
+        next += stepMicros;
+        uint64_t now = ofGetSystemTimeMicros();
+        if(next > now) {
+            std::this_thread::sleep_for(std::chrono::microseconds(next - now));
+        } else if(now - next > stepMicros * RATE / 4) {   //after a long stall the missed steps are dropped
+            next = now;
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+void Simulation::step(float dt) {
+
+    //input
+    Command command;
+    while(commands.pop(command)) {
+        switch(command.type) {
+            case MOVE_CAMERA:
+                cameraTarget = command.target;
+                state.isCameraMoving = true;
+                break;
+            case ROTATE_BOX:
+                if(!state.isBoxRotating) {   //the box rotates only if the previous rotation is over
+                    rotationDirection = command.value > 0 ? 1 : -1;
+                    rotationSpeed = max(1, command.speed);
+                    rotationStep = 0;
+                    state.isBoxRotating = true;
+                }
+                break;
+            case RESET_BOX:
+                state.boxRotation = 0;
+                state.isBoxRotating = false;
+                rotationStep = 0;
+                break;
+            case SCROLL:
+                scrollSpeed += command.value * SCROLL_IMPULSE;   //each wheel step pushes the ring, the speed decays
+                break;
+        }
+        state.inputSequence = command.sequence;
+        if(metrics) {
+            metrics -> inputLatency.observe(ofGetSystemTimeMicros() - command.pushMicros);
+        }
+    }
+
+    //camera movement: when the camera reaches the final position, it stops
+    if(state.isCameraMoving) {
+        state.cameraPosition = glm::mix(state.cameraPosition, cameraTarget, CAMERA_TWEEN);
+        glm::vec3 remaining = glm::abs(cameraTarget - state.cameraPosition);
+        if(remaining.x < 0.01f && remaining.y < 0.01f && remaining.z < 0.01f) {
+            state.isCameraMoving = false;
+        }
+    }
+
+    //box rotation: gradual rotation of the selected movie box, it stops after 90°
+    if(state.isBoxRotating) {
+        int delta = min(rotationSpeed, 90 - rotationStep);
+        state.boxRotation += rotationDirection * delta;
+        rotationStep += delta;
+        if(rotationStep == 90) {
+            rotationStep = 0;
+            state.isBoxRotating = false;
+        }
+    }
+
+    //ring scrolling: the fixed time step keeps the inertia equal at every frame rate
+    if(scrollSpeed != 0.f) {
+        state.scrollAngle += scrollSpeed * dt;
+        scrollSpeed *= pow(SCROLL_FRICTION, dt);
+        state.isScrolling = true;
+
+        //when the ring is almost still, it stops
+        if(abs(scrollSpeed) < 1.f) {
+            scrollSpeed = 0.f;
+            state.isScrolling = false;
+        }
+    }
+
+    state.tick++;
+    snapshots.getBack() = state;
+    snapshots.publish();
+}
+
+
+//--------------------------------------------------------------
+void Simulation::push(Command command) {
+    command.sequence = sequence + 1;
+    command.pushMicros = ofGetSystemTimeMicros();
+    if(commands.push(command)) {
+        sequence++;
+    } else {
+        ofLogWarning("Simulation") << "input queue full, a command was dropped";
+    }
+}
+
+
+//COMMANDS
+//--------------------------------------------------------------
+void Simulation::moveCamera(const glm::vec3 & target) {
+    Command command;
+    command.type = MOVE_CAMERA;
+    command.target = target;
+    command.value = 0.f;
+    command.speed = 0;
+    push(command);
+}
+
+
+//--------------------------------------------------------------
+void Simulation::rotateBox(int direction, int speed) {
+    Command command;
+    command.type = ROTATE_BOX;
+    command.value = direction;
+    command.speed = speed;
+    push(command);
+}
+
+
+//--------------------------------------------------------------
+void Simulation::resetBox() {
+    Command command;
+    command.type = RESET_BOX;
+    command.value = 0.f;
+    command.speed = 0;
+    push(command);
+}
+
+
+//--------------------------------------------------------------
+void Simulation::scroll(float steps) {
+    Command command;
+    command.type = SCROLL;
+    command.value = steps;
+    command.speed = 0;
+    push(command);
+}
+
+
+//GETTER
+//--------------------------------------------------------------
+const Simulation::Snapshot & Simulation::getSnapshot() const {
+    return snapshots.getFront();
+}
+
+
+//--------------------------------------------------------------
+bool Simulation::isBehind() const {
+    return sequence > snapshots.getFront().inputSequence;
+}
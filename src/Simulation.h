@@ -0,0 +1,82 @@
+#pragma once
+
+#include "ofMain.h"   //includes the Header file of OpenFrameworks
+#include "Metrics.h"
+#include "SpscQueue.h"
+#include "TripleBuffer.h"
+
+class Simulation : public ofThread {
+
+    public:
+        static const int RATE = 60;   //simulation steps per second, independent from the frame rate
+
+        //interaction and animation state published after each step, the render thread only reads it
+        struct Snapshot {
+            uint64_t tick;             //number of steps performed
+            uint64_t inputSequence;    //last command applied
+            glm::vec3 cameraPosition;  //tweened position of the camera
+            bool isCameraMoving;       //true until the camera reaches its target
+            int boxRotation;           //angle rotation of the selected movie box
+            bool isBoxRotating;        //true during a 90° rotation of the selected movie box
+            float scrollAngle;         //angle of the rings around the Oscar statuette
+            bool isScrolling;          //true while the rings are sliding
+        };
+
+    private:
+        //input sent by the render thread
+        enum CommandType {
+            MOVE_CAMERA,   //the camera moves towards 'target'
+            ROTATE_BOX,    //the selected movie box rotates by 90° in direction 'value' at speed 'speed'
+            RESET_BOX,     //the rotation of the selected movie box is reset
+            SCROLL         //the rings receive an impulse of 'value' wheel steps
+        };
+
+        struct Command {
+            CommandType type;
+            glm::vec3 target;
+            float value;
+            int speed;
+            uint64_t sequence;     //order of the command, acknowledged in the snapshots
+            uint64_t pushMicros;   //time when the command was sent, to measure its wait in the queue
+        };
+
+        static const size_t QUEUE_SIZE = 256;
+
+        //ATTRIBUTES
+        SpscQueue<Command, QUEUE_SIZE> commands;   //input from the render thread to the simulation
+        TripleBuffer<Snapshot> snapshots;          //state from the simulation to the render thread
+        Snapshot state;                            //state owned by the simulation
+        glm::vec3 cameraTarget;                    //final position of the camera
+        int rotationDirection;                     //1 to the right, -1 to the left
+        int rotationStep;                          //rotation performed by the current 90° rotation
+        int rotationSpeed;                         //degrees per step of the current rotation
+        float scrollSpeed;                         //angular speed of the rings in degrees per second
+        uint64_t sequence;                         //last command pushed, only used by the render thread
+        bool lockstep;                             //true if the simulation steps once per frame on the render thread
+        Metrics * metrics;                         //input latency is observed here, it can be null
+
+        void threadedFunction();    //steps at 'RATE' until the thread is stopped
+        void step(float dt);        //applies the pending commands, advances the animations and publishes the state
+        void push(Command command);
+
+    public:
+        //INTERFACE
+        Simulation();    //Simulation class constructor
+        ~Simulation();   //Simulation class destructor, it stops the thread
+
+        //starts from a still camera in 'cameraPosition' discarding the commands sent before; in lockstep mode no thread
+        //is started and update performs one step per frame, so recorded, replayed and captured runs are deterministic
+        void start(const glm::vec3 & cameraPosition, bool isLockstep, Metrics * m);
+        void stop();
+        void update();   //called once per frame by the render thread, it takes the latest snapshot
+
+        //commands, they are applied at the next step
+        void moveCamera(const glm::vec3 & target);
+        void rotateBox(int direction, int speed);
+        void resetBox();
+        void scroll(float steps);
+
+        //GETTER
+        const Snapshot & getSnapshot() const;   //latest snapshot taken by update
+        bool isBehind() const;                  //true if some commands are not yet applied in the snapshot
+};
@@ -0,0 +1,217 @@
+/*
+ SoakTest.cpp
+ OscarUniverse
+
+ SoakTest class: drives the application for hours through every movie box (select, rotate all faces, play and pause the
+ trailer, exit) while sampling memory, GL objects, file descriptors and threads. At the end, the samples are analysed
+ and the test fails if any of them keeps growing, which is the sign of a resource leak
+ */
+
+#include "SoakTest.h"
+#include "ProcessStats.h"
+
+//the trend analysis needs at least this number of samples after the warmup
+static const size_t MIN_SAMPLES = 8;
+
+//resident memory can fluctuate by this amount without being considered a leak
+static const double MEMORY_TOLERANCE = 16.0 * 1024 * 1024;
+
+
+//--------------------------------------------------------------
+SoakTest::SoakTest() {
+    running = false;
+    duration = 0.f;
+    sampleInterval = 30.f;
+    startTime = 0.f;
+    lastSampleTime = 0.f;
+    stepTime = 0.f;
+    warmup = 0.f;
+
+    scriptStep = 0;
+    movieCount = 0;
+    currentMovie = 0;
+    cycles = 0;
+
+    //the trailer face is reached after two rotations (180°), the last two rotations bring back the poster face
+    script = {SELECT, ROTATE_RIGHT, ROTATE_RIGHT, TOGGLE_TRAILER, TOGGLE_TRAILER, ROTATE_RIGHT, ROTATE_RIGHT, LEAVE};
+    waits  = {1.f,    0.5f,         0.5f,         5.f,            0.5f,           0.5f,         0.5f,         1.f};
+}
+
+
+//--------------------------------------------------------------
+void SoakTest::start(float hours, int movies, string report) {
+    if(movies <= 0) {
+        ofLogError("SoakTest") << "no movie boxes to test";
+        return;
+    }
+
+    duration = hours * 3600.f;
+    sampleInterval = ofClamp(duration / 240.f, 1.f, 30.f);   //short tests still collect enough samples
+    warmup = duration * 0.1f;
+    movieCount = movies;
+    reportPath = report;
+
+    startTime = ofGetElapsedTimef();
+    lastSampleTime = -sampleInterval;
+    stepTime = startTime;
+    scriptStep = 0;
+    currentMovie = 0;
+    cycles = 0;
+    samples.clear();
+    running = true;
+
+    ofLogNotice("SoakTest") << "soak test started: " << hours << " hours over " << movies << " movie boxes";
+}
+
+
+//--------------------------------------------------------------
+SoakTest::Action SoakTest::update(bool idle) {
+    if(!running || !idle) {
+        return NONE;
+    }
+
+    //each action waits for the previous one to settle
+    float now = ofGetElapsedTimef();
+    size_t previousStep = scriptStep == 0 ? script.size() - 1 : scriptStep - 1;
+    if(now - stepTime < waits[previousStep]) {
+        return NONE;
+    }
+
+    Action action = script[scriptStep];
+    stepTime = now;
+    scriptStep++;
+
+    //the script is over, the next movie box is tested
+    if(scriptStep == script.size()) {
+        scriptStep = 0;
+        currentMovie = (currentMovie + 1) % movieCount;
+        cycles++;
+
+        //the warmup lasts at least one full pass over the catalog
+        if(cycles == movieCount) {
+            warmup = max(warmup, now - startTime);
+        }
+    }
+
+    return action;
+}
+
+
+//--------------------------------------------------------------
+void SoakTest::sample() {
+    if(!running) {
+        return;
+    }
+
+    float elapsed = ofGetElapsedTimef() - startTime;
+    if(elapsed - lastSampleTime < sampleInterval) {
+        return;
+    }
+    lastSampleTime = elapsed;
+
+    Sample s;
+    s.time = elapsed;
+    s.memory = ProcessStats::getResidentMemory();
+    s.textures = ProcessStats::getLiveTextures();
+    s.buffers = ProcessStats::getLiveBuffers();
+    s.files = ProcessStats::getOpenFileDescriptors();
+    s.threads = ProcessStats::getThreadCount();
+    samples.push_back(s);
+}
+
+
+//--------------------------------------------------------------
+bool SoakTest::finish() {
+    if(!running) {
+        return true;
+    }
+    running = false;
+
+    ofFile report(reportPath, ofFile::WriteOnly);
+    report << "duration_s " << ofGetElapsedTimef() - startTime << "\n";
+    report << "movies_visited " << cycles << "\n";
+    report << "warmup_s " << warmup << "\n";
+
+    bool leak = false;
+    leak |= isGrowing([](const Sample & s) { return (double)s.memory; }, MEMORY_TOLERANCE, "rss_bytes", report);
+    leak |= isGrowing([](const Sample & s) { return (double)s.textures; }, 0.0, "gl_textures", report);
+    leak |= isGrowing([](const Sample & s) { return (double)s.buffers; }, 0.0, "gl_buffers", report);
+    leak |= isGrowing([](const Sample & s) { return (double)s.files; }, 0.0, "file_descriptors", report);
+    leak |= isGrowing([](const Sample & s) { return (double)s.threads; }, 0.0, "threads", report);
+
+    report << "result " << (leak ? "FAIL" : "PASS") << "\n";
+
+    //all samples, to plot the resource usage over time
+    report << "time_s,rss_bytes,gl_textures,gl_buffers,file_descriptors,threads\n";
+    for(auto & s : samples) {
+        report << s.time << "," << s.memory << "," << s.textures << "," << s.buffers << ","
+               << s.files << "," << s.threads << "\n";
+    }
+
+    if(leak) {
+        ofLogError("SoakTest") << "resource growth detected, see " << reportPath;
+    } else {
+        ofLogNotice("SoakTest") << "no resource growth detected, report written to " << reportPath;
+    }
+    return !leak;
+}
+
+
+//--------------------------------------------------------------
+bool SoakTest::isGrowing(std::function<double(const Sample &)> value, double tolerance, string name, ofFile & report) {
+    //samples taken during the warmup are excluded
+    vector<double> values;
+    vector<double> times;
+    for(auto & s : samples) {
+        if(s.time >= warmup) {
+            values.push_back(value(s));
+            times.push_back(s.time);
+        }
+    }
+
+    if(values.size() < MIN_SAMPLES) {
+        report << name << " not_enough_samples " << values.size() << "\n";
+        return false;
+    }
+
+    //a resource is growing if the lowest value of the last quarter is above the highest value of the first quarter
+    size_t quarter = values.size() / 4;
+    double firstMax = *max_element(values.begin(), values.begin() + quarter);
+    double lastMin = *min_element(values.end() - quarter, values.end());
+
+    //least squares slope, reported per hour
+    double meanTime = accumulate(times.begin(), times.end(), 0.0) / times.size();
+    double meanValue = accumulate(values.begin(), values.end(), 0.0) / values.size();
+    double covariance = 0.0;
+    double variance = 0.0;
+    for(size_t i = 0; i < values.size(); i++) {
+        covariance += (times[i] - meanTime) * (values[i] - meanValue);
+        variance += (times[i] - meanTime) * (times[i] - meanTime);
+    }
+    double slope = variance > 0.0 ? covariance / variance * 3600.0 : 0.0;
+
+    bool growing = lastMin > firstMax + tolerance && slope > 0.0;
+
+    report << name << " first_quarter_max " << firstMax << " last_quarter_min " << lastMin
+           << " slope_per_hour " << slope << " " << (growing ? "GROWING" : "stable") << "\n";
+    return growing;
+}
+
+
+//GETTER
+//--------------------------------------------------------------
+bool SoakTest::isRunning() {
+    return running;
+}
+
+
+//--------------------------------------------------------------
+bool SoakTest::isOver() {
+    return running && ofGetElapsedTimef() - startTime >= duration;
+}
+
+
+//--------------------------------------------------------------
+int SoakTest::getCurrentMovie() {
+    return currentMovie;
+}
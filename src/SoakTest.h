@@ -0,0 +1,61 @@
+#pragma once
+
+#include "ofMain.h"   //includes the Header file of OpenFrameworks
+
+class SoakTest {
+
+    public:
+        //actions that ofApp performs on behalf of the soak test
+        enum Action {
+            NONE,
+            SELECT,           //enter the movie box returned by getCurrentMovie()
+            ROTATE_RIGHT,     //rotate the selected movie box by 90°
+            TOGGLE_TRAILER,   //play or pause the trailer of the selected movie box
+            LEAVE             //exit from the selected movie box
+        };
+
+        struct Sample {
+            float time;          //seconds since the beginning of the test
+            uint64_t memory;     //resident memory in bytes
+            int textures;        //live GL textures
+            int buffers;         //live GL buffers
+            int files;           //open file descriptors
+            int threads;         //threads of the process
+        };
+
+    private:
+        //ATTRIBUTES
+        bool running;            //if true, the soak test drives the application
+        float duration;          //duration of the test in seconds
+        float sampleInterval;    //seconds between two resource samples
+        float startTime;         //time when the test started
+        float lastSampleTime;    //time of the last resource sample
+        float stepTime;          //time when the last action was performed
+        float warmup;            //seconds excluded from the trend analysis (caches and pools filling up)
+
+        vector<Action> script;   //actions performed on each movie box
+        vector<float> waits;     //seconds to wait after each action of the script
+        size_t scriptStep;       //index of the next action of the script
+        int movieCount;          //number of movie boxes to cycle through
+        int currentMovie;        //index of the movie box currently tested
+        int cycles;              //number of movie boxes visited
+
+        vector<Sample> samples;  //resource usage over time
+        string reportPath;       //file where the report is written
+
+        bool isGrowing(std::function<double(const Sample &)> value, double tolerance, string name, ofFile & report);
+
+    public:
+        //INTERFACE
+        SoakTest();   //SoakTest class constructor
+
+        void start(float hours, int movies, string report);   //starts cycling through 'movies' boxes for 'hours'
+        Action update(bool idle);   //returns the next action to perform, 'idle' is true when no animation is running
+        void sample();              //samples resource usage, it must be called from the GL thread
+        bool finish();              //analyses the samples and writes the report, returns false if a leak is found
+
+        //GETTER
+        bool isRunning();
+        bool isOver();
+        int getCurrentMovie();
+};
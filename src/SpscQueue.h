@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+
+//lock-free bounded queue between one producer and one consumer thread
+template<class T, size_t CAPACITY>
+class SpscQueue {
+
+    private:
+        //ATTRIBUTES
+        T items[CAPACITY];
+        std::atomic<size_t> head;   //next item to pop, written only by the consumer
+        std::atomic<size_t> tail;   //next free item, written only by the producer
+
+    public:
+        //INTERFACE
+        SpscQueue() : head(0), tail(0) {}
+
+        //producer side: false if the queue is full
+        bool push(const T & item) {
+            size_t t = tail.load(std::memory_order_relaxed);
+            if(t - head.load(std::memory_order_acquire) == CAPACITY) {
+                return false;
+            }
+            items[t % CAPACITY] = item;
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        //consumer side: false if the queue is empty
+        bool pop(T & item) {
+            size_t h = head.load(std::memory_order_relaxed);
+            if(h == tail.load(std::memory_order_acquire)) {
+                return false;
+            }
+            item = items[h % CAPACITY];
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+};
@@ -0,0 +1,132 @@
+/*
+ StateCache.cpp
+ OscarUniverse
+
+ StateCache class: depth test, lighting, face culling and lights are set through this class, which remembers the last
+ value and drops the calls that would leave the state unchanged. The cache is invalidated at the beginning of each
+ frame and around code that changes the state by itself, so a dropped call is always a real no-op. The counters of
+ issued and suppressed calls are logged and exported by the metrics endpoint
+ */
+
+#include "StateCache.h"
+
+//static variables inside a class should be initialized explicitly outside the class
+int StateCache::depthTest = StateCache::UNKNOWN;
+int StateCache::lighting = StateCache::UNKNOWN;
+int StateCache::cullFace = StateCache::UNKNOWN;
+int StateCache::cullFaceMode = StateCache::UNKNOWN;
+uint64_t StateCache::issued = 0;
+uint64_t StateCache::suppressed = 0;
+uint64_t StateCache::issuedTotal = 0;
+uint64_t StateCache::suppressedTotal = 0;
+float StateCache::lastLogTime = 0.f;
+
+
+//--------------------------------------------------------------
+bool StateCache::change(int & cached, int value) {
+    if(cached == value) {
+        suppressed++;
+        return false;
+    }
+    cached = value;
+    issued++;
+    return true;
+}
+
+
+//--------------------------------------------------------------
+void StateCache::invalidate() {
+    depthTest = UNKNOWN;
+    lighting = UNKNOWN;
+    cullFace = UNKNOWN;
+    cullFaceMode = UNKNOWN;
+}
+
+
+//--------------------------------------------------------------
+void StateCache::setDepthTest(bool b) {
+    if(change(depthTest, b)) {
+        if(b) {
+            ofEnableDepthTest();
+        } else {
+            ofDisableDepthTest();
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+void StateCache::setLighting(bool b) {
+    if(change(lighting, b)) {
+        if(b) {
+            ofEnableLighting();
+        } else {
+            ofDisableLighting();
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+void StateCache::setCullFace(bool b) {
+    if(change(cullFace, b)) {
+        if(b) {
+            glEnable(GL_CULL_FACE);
+        } else {
+            glDisable(GL_CULL_FACE);
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+void StateCache::setCullFaceMode(GLenum mode) {
+    if(change(cullFaceMode, mode)) {
+        glCullFace(mode);
+    }
+}
+
+
+//--------------------------------------------------------------
+void StateCache::setLight(ofLight & light, bool b) {
+    //the light keeps its own state, enabling a light also enables lighting
+    int enabled = light.getIsEnabled();
+    if(change(enabled, b)) {
+        if(b) {
+            light.enable();
+            lighting = UNKNOWN;
+        } else {
+            light.disable();
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+void StateCache::endFrame() {
+    issuedTotal += issued;
+    suppressedTotal += suppressed;
+
+    float now = ofGetElapsedTimef();
+    if(now - lastLogTime > 10.f) {
+        ofLogNotice("StateCache") << "state calls in the last frame: " << issued << " issued, " << suppressed
+                                  << " suppressed";
+        lastLogTime = now;
+    }
+
+    issued = 0;
+    suppressed = 0;
+}
+
+
+//GETTER
+//--------------------------------------------------------------
+uint64_t StateCache::getIssuedTotal() {
+    return issuedTotal;
+}
+
+
+//--------------------------------------------------------------
+uint64_t StateCache::getSuppressedTotal() {
+    return suppressedTotal;
+}
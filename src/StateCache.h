@@ -0,0 +1,40 @@
+#pragma once
+
+#include "ofMain.h"   //includes the Header file of OpenFrameworks
+
+//last GL state set by the application, the calls that would not change it are not sent to the driver; the state is
+//global like the GL context, so it is static
+class StateCache {
+
+    private:
+        static const int UNKNOWN = -1;   //the state was changed outside the cache, the next call is always issued
+
+        //ATTRIBUTES
+        static int depthTest;          //1 enabled, 0 disabled, UNKNOWN
+        static int lighting;
+        static int cullFace;
+        static int cullFaceMode;       //GL_FRONT, GL_BACK or UNKNOWN
+        static uint64_t issued;        //calls sent to the driver in the current frame
+        static uint64_t suppressed;    //calls skipped in the current frame
+        static uint64_t issuedTotal;   //calls of the whole run
+        static uint64_t suppressedTotal;
+        static float lastLogTime;      //time when the counters were last written in the log
+
+        static bool change(int & cached, int value);   //true if 'value' differs from 'cached', the call is counted
+
+    public:
+        //INTERFACE
+        static void invalidate();   //forgets the state, after code that changes it directly or a change of GL context
+
+        static void setDepthTest(bool b);
+        static void setLighting(bool b);
+        static void setCullFace(bool b);
+        static void setCullFaceMode(GLenum mode);
+        static void setLight(ofLight & light, bool b);
+
+        static void endFrame();     //closes the counters of the frame, they are logged every 10 seconds
+
+        //GETTER
+        static uint64_t getIssuedTotal();
+        static uint64_t getSuppressedTotal();
+};
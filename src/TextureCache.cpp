@@ -0,0 +1,398 @@
+/*
+ TextureCache.cpp
+ OscarUniverse
+
+ TextureCache class: decoding the JPG and PNG images of the movie boxes and generating their mipmaps is most of the
+ start time of the application. The first time an image is loaded, its mipmap levels are built on the CPU, uploaded
+ and stored in a cache file by a writer thread; the next launches upload those levels directly. A cache file is used
+ only if the source image and the GL driver (vendor, renderer and version) are the same of when it was written,
+ otherwise the image is decoded again and the file is replaced. The folder has a size budget: reading a file touches
+ it, and the files not read for the longest time are removed first. Reading and decoding do not touch GL, so the
+ movie boxes run them on a loader thread and the render thread only uploads the result
+ */
+
+#include "TextureCache.h"
+#include "ProcessStats.h"
+#include <sys/stat.h>
+#include <utime.h>
+
+//static variables inside a class should be initialized explicitly outside the class
+string TextureCache::directory;
+uint64_t TextureCache::maxBytes = 0;
+uint64_t TextureCache::driverHash = 0;
+std::atomic<int> TextureCache::hits(0);
+std::atomic<int> TextureCache::misses(0);
+ofThreadChannel<TextureCache::Write> TextureCache::writes;
+TextureCache::Writer TextureCache::writer;
+
+
+//size of a mipmap level
+static int levelSize(int size, int level) {
+    return max(1, size >> level);
+}
+
+
+//--------------------------------------------------------------
+void TextureCache::setup(string folder, int megabytes) {
+    if(folder.empty()) {
+        directory = "";
+        return;
+    }
+    directory = ofToDataPath(folder, true);
+    ofDirectory::createDirectory(directory, false, true);
+    maxBytes = (uint64_t)max(0, megabytes) * 1024 * 1024;
+
+    //textures read back from another driver could have a different layout
+    string driver;
+    for(GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        const GLubyte * value = glGetString(name);
+        driver += value ? (const char *)value : "";
+        driver += "\n";
+    }
+    driverHash = hash(driver.data(), driver.size());
+
+    //the size of the folder is counted by the writer thread, the start does not wait for it
+    writer.bytes = 0;
+    writer.startThread();
+}
+
+
+//--------------------------------------------------------------
+void TextureCache::close() {
+    if(!writer.isThreadRunning()) {
+        return;
+    }
+    writes.send(Write());   //an empty write stops the thread after the files queued before it
+    writer.waitForThread(false);
+}
+
+
+//--------------------------------------------------------------
+bool TextureCache::decode(Image & image, string file, bool mipmaps, bool mirror) {
+    image.mipmaps = mipmaps;
+    image.mirror = mirror;
+    image.isCached = false;
+    image.path = "";
+    image.sourceHash = 0;
+    image.levels.clear();
+
+    ofBuffer source = ofBufferFromFile(file, true);
+    if(source.size() == 0) {
+        ofLogError("TextureCache") << "couldn't load image from \"" << file << "\"";
+        return false;
+    }
+
+    //the cache file is named after the source and the options, it is overwritten when the source or the driver change
+    if(!directory.empty()) {
+        string key = file + (mipmaps ? ":mipmaps" : "") + (mirror ? ":mirror" : "");
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.tex", (unsigned long long)hash(key.data(), key.size()));
+        image.path = ofFilePath::join(directory, name);
+        image.sourceHash = hash(source.getData(), source.size());
+
+        if(read(image, image.sourceHash, mirror)) {
+            image.isCached = true;
+            hits++;
+
+            //the file is touched by the writer thread, it becomes the last one to be evicted
+            Write touch;
+            touch.path = image.path;
+            writes.send(std::move(touch));
+            return true;
+        }
+    }
+
+    //cold path: the image is decoded and its levels are stored for the next launch
+    image.levels.resize(1);
+    if(!ofLoadImage(image.levels[0], source)) {
+        ofLogError("TextureCache") << "couldn't decode image \"" << file << "\"";
+        image.levels.clear();
+        return false;
+    }
+    if(mirror) {
+        image.levels[0].mirror(false, true);
+    }
+    misses++;
+
+    //without the cache the mipmaps are generated by the GPU at the upload
+    if(!image.path.empty()) {
+        if(mipmaps) {
+            buildMipmaps(image);
+        }
+
+        const ofPixels & pixels = image.levels[0];
+        Write file;
+        file.path = image.path;
+        memcpy(file.header.magic, "OSCT", 4);
+        file.header.version = VERSION;
+        file.header.sourceHash = image.sourceHash;
+        file.header.driverHash = driverHash;
+        file.header.width = pixels.getWidth();
+        file.header.height = pixels.getHeight();
+        file.header.textureWidth = pixels.getWidth();
+        file.header.textureHeight = pixels.getHeight();
+        file.header.glInternalFormat = ofGetGLInternalFormat(pixels);
+        file.header.glFormat = ofGetGLFormat(pixels);
+        file.header.channels = pixels.getNumChannels();
+        file.header.levels = image.levels.size();
+        file.header.mirrored = mirror ? 1 : 0;
+        file.levels = image.levels;
+        writes.send(std::move(file));
+    }
+    return true;
+}
+
+
+//--------------------------------------------------------------
+void TextureCache::buildMipmaps(Image & image) {
+    int width = image.levels[0].getWidth();
+    int height = image.levels[0].getHeight();
+    int channels = image.levels[0].getNumChannels();
+    image.levels.resize((int)floor(log2(max(width, height))) + 1);
+
+    //box filter: each pixel is the average of the 2x2 pixels of the previous level, the last row and column are
+    //repeated when a size is odd
+    for(size_t level = 1; level < image.levels.size(); level++) {
+        const ofPixels & source = image.levels[level - 1];
+        ofPixels & mip = image.levels[level];
+        mip.allocate(levelSize(width, level), levelSize(height, level), source.getPixelFormat());
+
+        int sourceWidth = source.getWidth();
+        int sourceHeight = source.getHeight();
+        const unsigned char * from = source.getData();
+        unsigned char * to = mip.getData();
+        for(int y = 0; y < (int)mip.getHeight(); y++) {
+            const unsigned char * row0 = from + (size_t)min(2 * y, sourceHeight - 1) * sourceWidth * channels;
+            const unsigned char * row1 = from + (size_t)min(2 * y + 1, sourceHeight - 1) * sourceWidth * channels;
+            for(int x = 0; x < (int)mip.getWidth(); x++) {
+                int x0 = min(2 * x, sourceWidth - 1) * channels;
+                int x1 = min(2 * x + 1, sourceWidth - 1) * channels;
+                for(int c = 0; c < channels; c++) {
+                    *to++ = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4;
+                }
+            }
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+void TextureCache::upload(ofTexture & texture, const Image & image) {
+    const ofPixels & pixels = image.levels[0];
+    ofTextureData & data = texture.getTextureData();
+
+    //a texture of the same size and format keeps its storage, only its content is replaced
+    bool isReused = texture.isAllocated() && (int)data.width == (int)pixels.getWidth() &&
+                    (int)data.height == (int)pixels.getHeight() &&
+                    data.glInternalFormat == ofGetGLInternalFormat(pixels);
+    if(!isReused) {
+        bool wasAllocated = texture.isAllocated();
+        texture.allocate(pixels);
+        data.hasMipmap = false;   //the levels of the previous storage are gone
+        if(!wasAllocated) {
+            ProcessStats::addTextures(1);
+        }
+    }
+    texture.loadData(pixels);
+
+    //the levels read from the cache or built by the decode are uploaded as they are; a padded texture does not match
+    //their sizes and generates its own
+    bool isPadded = (int)data.tex_w != (int)pixels.getWidth() || (int)data.tex_h != (int)pixels.getHeight();
+    if(image.levels.size() > 1 && !isPadded) {
+        glBindTexture(data.textureTarget, data.textureID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for(size_t level = 1; level < image.levels.size(); level++) {
+            const ofPixels & mip = image.levels[level];
+            if(data.hasMipmap) {
+                glTexSubImage2D(data.textureTarget, level, 0, 0, mip.getWidth(), mip.getHeight(), ofGetGLFormat(mip),
+                                GL_UNSIGNED_BYTE, mip.getData());
+            } else {
+                glTexImage2D(data.textureTarget, level, data.glInternalFormat, mip.getWidth(), mip.getHeight(), 0,
+                             ofGetGLFormat(mip), GL_UNSIGNED_BYTE, mip.getData());
+            }
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(data.textureTarget, 0);
+        data.hasMipmap = true;
+    } else if(image.mipmaps) {
+        texture.generateMipmap();
+    }
+}
+
+
+//--------------------------------------------------------------
+bool TextureCache::load(ofTexture & texture, string file, bool mipmaps, bool mirror) {
+    Image image;
+    if(!decode(image, file, mipmaps, mirror)) {
+        return false;
+    }
+    upload(texture, image);
+    return true;
+}
+
+
+//--------------------------------------------------------------
+bool TextureCache::read(Image & image, uint64_t sourceHash, bool mirror) {
+    if(!ofFile::doesFileExist(image.path, false)) {
+        return false;
+    }
+    ofBuffer cached = ofBufferFromFile(image.path, true);
+    if(cached.size() < sizeof(Header)) {
+        return false;
+    }
+
+    //any mismatch makes the caller decode the image again; padded textures are not read from the cache, their levels
+    //would not match the size of the image
+    Header header;
+    memcpy(&header, cached.getData(), sizeof(Header));
+    if(memcmp(header.magic, "OSCT", 4) != 0 || header.version != VERSION || header.sourceHash != sourceHash ||
+       header.driverHash != driverHash || header.mirrored != (mirror ? 1u : 0u) ||
+       (header.levels > 1) != image.mipmaps || header.textureWidth != header.width ||
+       header.textureHeight != header.height) {
+        return false;
+    }
+    ofPixelFormat format;
+    switch(header.channels) {
+        case 1: format = OF_PIXELS_GRAY; break;
+        case 3: format = OF_PIXELS_RGB; break;
+        case 4: format = OF_PIXELS_RGBA; break;
+        default: return false;
+    }
+    size_t expected = sizeof(Header);
+    for(uint32_t level = 0; level < header.levels; level++) {
+        expected += (size_t)levelSize(header.width, level) * levelSize(header.height, level) * header.channels;
+    }
+    if(cached.size() != expected) {
+        return false;
+    }
+
+    //every level is copied as it was stored
+    const char * pixels = cached.getData() + sizeof(Header);
+    image.levels.resize(header.levels);
+    for(uint32_t level = 0; level < header.levels; level++) {
+        int width = levelSize(header.width, level);
+        int height = levelSize(header.height, level);
+        image.levels[level].setFromPixels((const unsigned char *)pixels, width, height, format);
+        pixels += (size_t)width * height * header.channels;
+    }
+    return true;
+}
+
+
+//--------------------------------------------------------------
+void TextureCache::Writer::threadedFunction() {
+    bytes = evict();
+
+    Write file;
+    while(writes.receive(file)) {
+        if(file.path.empty()) {
+            break;   //TextureCache::close
+        }
+        if(file.levels.empty()) {
+            utime(file.path.c_str(), nullptr);   //the modification time orders the files from the least recently used
+            continue;
+        }
+        //a replaced file is counted once
+        struct stat info;
+        uint64_t previous = stat(file.path.c_str(), &info) == 0 ? info.st_size : 0;
+        uint64_t size = write(file);
+        if(size > 0) {
+            bytes = bytes - min(bytes, previous) + size;
+        }
+        if(bytes > maxBytes) {
+            bytes = evict();
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+uint64_t TextureCache::write(const Write & file) {
+    //the file is written aside and renamed, so a crash never leaves a truncated cache file
+    string temporary = file.path + ".tmp";
+    ofstream out(temporary, ios::binary);
+    out.write((const char *)&file.header, sizeof(Header));
+    uint64_t size = sizeof(Header);
+    for(const ofPixels & level : file.levels) {
+        out.write((const char *)level.getData(), level.getTotalBytes());
+        size += level.getTotalBytes();
+    }
+
+    out.close();
+    if(!out.good()) {
+        ofLogWarning("TextureCache") << "couldn't write \"" << file.path << "\"";
+        ofFile::removeFile(temporary, false);
+        return 0;
+    }
+    ofFile::moveFromTo(temporary, file.path, false, true);
+    return size;
+}
+
+
+//--------------------------------------------------------------
+uint64_t TextureCache::evict() {
+    //size and last use of the cache files
+    struct CacheFile {
+        time_t used;
+        uint64_t size;
+        string path;
+    };
+    vector<CacheFile> files;
+    uint64_t bytes = 0;
+    ofDirectory folder(directory);
+    folder.allowExt("tex");
+    folder.listDir();
+    for(size_t i = 0; i < folder.size(); i++) {
+        struct stat info;
+        string path = folder.getPath(i);
+        if(stat(path.c_str(), &info) == 0) {
+            files.push_back({info.st_mtime, (uint64_t)info.st_size, path});
+            bytes += info.st_size;
+        }
+    }
+    if(bytes <= maxBytes) {
+        return bytes;
+    }
+
+    //the least recently used files are removed until a tenth of the budget is free, so the next writes do not
+    //evict again at once
+    sort(files.begin(), files.end(), [](const CacheFile & a, const CacheFile & b) { return a.used < b.used; });
+    uint64_t target = maxBytes - maxBytes / 10;
+    int removed = 0;
+    for(const CacheFile & file : files) {
+        if(bytes <= target) {
+            break;
+        }
+        if(ofFile::removeFile(file.path, false)) {
+            bytes -= file.size;
+            removed++;
+        }
+    }
+    ofLogNotice("TextureCache") << "removed " << removed << " least recently used files, "
+                                << bytes / (1024 * 1024) << " MB left";
+    return bytes;
+}
+
+
+//--------------------------------------------------------------
+uint64_t TextureCache::hash(const char * data, size_t size, uint64_t seed) {
+    uint64_t value = seed;
+    for(size_t i = 0; i < size; i++) {
+        value ^= (unsigned char)data[i];
+        value *= 1099511628211ULL;
+    }
+    return value;
+}
+
+
+//GETTER
+//--------------------------------------------------------------
+int TextureCache::getHits() {
+    return hits;
+}
+
+
+//--------------------------------------------------------------
+int TextureCache::getMisses() {
+    return misses;
+}
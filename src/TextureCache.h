@@ -0,0 +1,97 @@
+#pragma once
+
+#include "ofMain.h"   //includes the Header file of OpenFrameworks
+#include <atomic>
+
+//on-disk cache of decoded textures with their mipmaps; all movie boxes share it, so its state is static
+class TextureCache {
+
+    public:
+        //image decoded on any thread, uploaded later by the GL thread
+        struct Image {
+            vector<ofPixels> levels;   //mipmap levels read from the cache file or built from the decoded image, only
+                                       //the decoded image if the cache is disabled
+            bool mipmaps;              //if true, the texture has mipmaps
+            bool mirror;               //if true, the image was flipped horizontally
+            bool isCached;             //true if 'levels' were read from a cache file
+            string path;               //cache file of the image, empty if the cache is disabled
+            uint64_t sourceHash;       //hash of the source image, stored in the cache file
+        };
+
+    private:
+        static const uint32_t VERSION = 2;   //changes when the format or the content of the cache files changes; 2 stores
+                                             //mipmaps built on the CPU and no padded textures
+
+        //first bytes of a cache file
+        struct Header {
+            char magic[4];             //"OSCT"
+            uint32_t version;          //format of the file
+            uint64_t sourceHash;       //FNV-1a hash of the source image file
+            uint64_t driverHash;       //FNV-1a hash of GL vendor, renderer and version
+            uint32_t width;            //size of the image
+            uint32_t height;
+            uint32_t textureWidth;     //size of the stored levels, files of padded textures are no longer written
+            uint32_t textureHeight;
+            int32_t glInternalFormat;
+            int32_t glFormat;
+            uint32_t channels;         //bytes per pixel
+            uint32_t levels;           //mipmap levels stored after the header, 1 if the texture has no mipmaps
+            uint32_t mirrored;         //1 if the image was flipped horizontally
+        };
+
+        //cache file stored by the writer thread
+        struct Write {
+            string path;                 //cache file
+            Header header;
+            vector<ofPixels> levels;     //mipmap levels to store, empty if the file was read and is only touched
+        };
+
+        //worker thread writing the cache files and evicting the least recently used ones, so neither the render
+        //thread nor the loader thread wait for the disk
+        class Writer : public ofThread {
+            public:
+                uint64_t bytes;          //size of the cache files, counted at the start and after every write
+                void threadedFunction();
+        };
+
+        //ATTRIBUTES
+        static string directory;            //folder of the cache files, empty if the cache is disabled
+        static uint64_t maxBytes;           //size budget of the cache files
+        static uint64_t driverHash;         //identity of the GL driver, cached textures of another driver are discarded
+        static std::atomic<int> hits;       //textures read from the cache
+        static std::atomic<int> misses;     //textures decoded from their source image
+        static ofThreadChannel<Write> writes;   //cache files waiting for the writer thread
+        static Writer writer;
+
+        static bool read(Image & image, uint64_t sourceHash, bool mirror);
+        static void buildMipmaps(Image & image);        //fills the mipmap levels of a decoded image on the CPU
+        static uint64_t write(const Write & file);      //stores the levels of an image and returns the size of the
+                                                        //file, 0 if it could not be written; writer thread only
+        static uint64_t evict();                        //removes the least recently used files over the budget and
+                                                        //returns the size of the remaining ones
+
+    public:
+        //INTERFACE
+        //it must be called with a GL context; an empty folder disables the cache, the least recently used files are
+        //removed when the folder is larger than 'megabytes'
+        static void setup(string folder, int megabytes = 512);
+        static void close();                //stores the cache files still queued and stops the writer thread
+
+        //reads an image from the cache if the source and the driver did not change since it was stored, otherwise
+        //decodes it; it does not touch GL, so it can be called from any thread after setup. 'mirror' flips the image
+        //horizontally
+        static bool decode(Image & image, string file, bool mipmaps, bool mirror = false);
+
+        //uploads a decoded image in 'texture', a texture of the same size and format is refilled without being
+        //allocated again; it must be called from the GL thread
+        static void upload(ofTexture & texture, const Image & image);
+
+        //decodes and uploads an image on the GL thread
+        static bool load(ofTexture & texture, string file, bool mipmaps, bool mirror = false);
+
+        static uint64_t hash(const char * data, size_t size, uint64_t seed = 14695981039346656037ULL);   //FNV-1a
+
+        //GETTER
+        static int getHits();
+        static int getMisses();
+};
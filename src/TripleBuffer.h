@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+
+//lock-free exchange of the latest value between one producer and one consumer thread: the producer writes the back
+//buffer and publishes it, the consumer takes the most recent published one; neither of them ever waits
+template<class T>
+class TripleBuffer {
+
+    private:
+        static const int INDEX = 3;   //bits of the buffer index in 'middle'
+        static const int FRESH = 4;   //set in 'middle' when it holds a value not consumed yet
+
+        //ATTRIBUTES
+        T buffers[3];
+        int back;                  //buffer written by the producer
+        std::atomic<int> middle;   //buffer exchanged between the two threads
+        int front;                 //buffer read by the consumer
+
+    public:
+        //INTERFACE
+        TripleBuffer() : back(0), middle(1), front(2) {}
+
+        //producer side
+        T & getBack() {
+            return buffers[back];
+        }
+
+        void publish() {
+            back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+        }
+
+        //consumer side: true if a new value was published since the last call
+        bool consume() {
+            if(!(middle.load(std::memory_order_relaxed) & FRESH)) {
+                return false;
+            }
+            front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+            return true;
+        }
+
+        const T & getFront() const {
+            return buffers[front];
+        }
+};
@@ -2,12 +2,53 @@
 #include "ofApp.h"
 
 //========================================================================
-int main( ){
-	ofSetupOpenGL(1024,768,OF_FULLSCREEN);			// <-------- setup the GL context
+int main(int argc, char *argv[]){
+	vector<string> arguments(argv, argv + argc);
+
+	//offscreen runs (e.g. replay on a build machine) use a hidden window with the size of the recorded session,
+	//the capture draws in its own offscreen target and needs no visible window either
+	if(find(arguments.begin(), arguments.end(), "--offscreen") != arguments.end() ||
+	   find(arguments.begin(), arguments.end(), "--capture") != arguments.end()) {
+		int width = 1024;
+		int height = 768;
+		InputRecorder::readWindowSize(ofApp::getArgument(arguments, "--replay"), width, height);
+
+		ofGLFWWindowSettings settings;
+		settings.setSize(width, height);
+		settings.visible = false;
+		ofCreateWindow(settings);
+	} else if(!ofApp::getArgument(arguments, "--box-display").empty()) {
+		//universe on the first monitor and opened box on the monitor given by command line, both windows use the
+		//same GL context so the textures, videos and meshes are loaded only once
+		ofGLFWWindowSettings settings;
+		settings.setSize(1024, 768);
+		settings.windowMode = OF_FULLSCREEN;
+		settings.monitor = 0;
+		shared_ptr<ofAppBaseWindow> mainWindow = ofCreateWindow(settings);
+
+		settings.monitor = ofToInt(ofApp::getArgument(arguments, "--box-display"));
+		settings.shareContextWith = mainWindow;
+		shared_ptr<ofAppBaseWindow> boxWindow = ofCreateWindow(settings);
+		boxWindow -> setVerticalSync(false);   //only the main window waits for the vertical sync, otherwise each
+		                                        //frame would wait for two refreshes; the box display is drawn from
+		                                        //the same update but its swap is not locked to its own refresh
+		ofVbo::disableVAOs();                  //vertex array objects can not be shared between contexts
+
+		shared_ptr<ofApp> app(new ofApp());
+		app -> arguments = arguments;
+		app -> boxWindow = boxWindow;
+		ofRunApp(mainWindow, app);
+		ofRunMainLoop();
+		return 0;
+	} else {
+		ofSetupOpenGL(1024,768,OF_FULLSCREEN);			// <-------- setup the GL context
+	}
 
 	// this kicks off the running of my app
 	// can be OF_WINDOW or OF_FULLSCREEN
 	// pass in width and height too:
-	ofRunApp(new ofApp());
+	ofApp * app = new ofApp();
+	app -> arguments = arguments;
+	ofRunApp(app);
 
 }
@@ -9,18 +9,34 @@
  */
 
 #include "ofApp.h"
+#include "ProcessStats.h"
+
+//number of movie boxes processed by each task of the per-frame stages
+static const size_t LAYOUT_CHUNK = 64;
+
+//number of movies whose assets are loaded in each frame when a cluster is expanded
+static const int ASSET_BUDGET = 2;
 
 
 //--------------------------------------------------------------
 void ofApp::setup(){
     
+    //decoded textures of the previous launches, by default in data/cache
+    float setupStart = ofGetElapsedTimef();
+    string cacheFolder = getArgument(arguments, "--texture-cache");
+    if(find(arguments.begin(), arguments.end(), "--no-texture-cache") == arguments.end()) {
+        string cacheSize = getArgument(arguments, "--texture-cache-size");   //megabytes
+        TextureCache::setup(cacheFolder.empty() ? "cache" : cacheFolder, cacheSize.empty() ? 512 : ofToInt(cacheSize));
+    }
+    
     //background
-    ofLoadImage(backgroundImage, "sky.jpg");   //upload image to use as background
+    TextureCache::load(backgroundImage, "sky.jpg", false);   //upload image to use as background
     
     //font
     //old OF default is 96 but this results in fonts looking larger than in other programs
     ofTrueTypeFont::setGlobalDpi(72);
     font.load("Ubuntu-Regular.ttf", 14);
+    lastFps = -1;
     
     ofEnableDepthTest();   //enable z buffer
     ofDisableArbTex();     //it uses GL_TEXTURE_2D textures and it supports mipmaps (a core OpenGL feature)
@@ -28,8 +44,6 @@ void ofApp::setup(){
     //camera
     cameraOrigin = ofPoint(0, 0, 1000);
     camera.setPosition(cameraOrigin);
-    targetBoxPosition = cameraOrigin;
-    moveCameraEnabled = false;
     isZoomingInsideBox = false;
     
     //model
@@ -38,90 +52,209 @@ void ofApp::setup(){
     model.setScale(0.7, 0.7, 0.7);        //shrinks 3D model
     isModelRotated = false;
     
-    movieSelected = NULL;
+    movieSelected = MovieStore::NO_MOVIE;
     
     //JSON data
-    getData("movies.json");   //retrieves data stored in the JSON file and saves them in the vector 'movies'
+    FilmBox::setupBoxes();    //dimensions and meshes shared by all movie boxes
+    getData("movies.json");   //retrieves data stored in the JSON file and saves them in 'movies'
+    
+    //galaxies: with a single cluster the camera starts in front of it, otherwise it shows all clusters; the soak test
+    //starts in front of the first cluster and cycles through the boxes of its ring
+    bool isSoakTest = !getArgument(arguments, "--soak").empty();
+    galaxies.layout(movies);
+    if(galaxies.size() > 1) {
+        camera.setFarClip(galaxies.getFarClip());
+    }
+    if(galaxies.size() == 1 || (isSoakTest && galaxies.size() > 0)) {
+        enterGalaxy(0);
+    } else {
+        leaveGalaxy();
+    }
+    camera.setPosition(cameraOrigin);   //the camera starts still, the simulation is started from here
+    hoveredGalaxy = -1;
     
     //default data to draw movies boxes around Oscar statuette
-    angleOffset = 360 / movies.size();   //the movies are uniformly distributed around an immaginary circle
-    angle = 0.0;                         //angle where to place the movie box
     distance = 450;                      //distance of the movies from the Oscar statuette
-    stepScrollBox = 0.f;                 //this value increments each loop by 'speedScrollBox'
     
     //parameters for raycasting
-    intersects = false;
-    indexIntersectedPrimitive = -1;
+    dist = 0.f;
+    indexIntersectedPrimitive = MovieStore::NO_MOVIE;
     foundIntersection = false;
     
+    //per-frame stages
+    string threads = getArgument(arguments, "--threads");
+    jobs.setup(threads.empty() ? -1 : ofToInt(threads));   //by default one worker for each core except this one
+    renderList.items.reserve(movies.size());   //the render list never allocates during the frame loop
+    renderList.hovered = MovieStore::NO_MOVIE;
+    renderList.hoveredDistance = 0.f;
+    renderList.hoveredGalaxy = -1;
+    
     //play icon
-    ofLoadImage(playIcon, "play-button.png");
+    TextureCache::load(playIcon, "play-button.png", false);
     playIcon.setAnchorPercent(0.5, 0.5);
-    for(int i = 0; i < movies.size(); i++) {
-        movies[i].setPlayIconTexture(&playIcon);   //set texture to use as play icon for each FilmBox
-    }
+    movies.setPlayIconTexture(&playIcon);   //set texture to use as play icon for each FilmBox
+    
+    //the assets of the clusters in view are loaded before the first frame
+    galaxies.update(camera.getPosition(), 0.f, movies, MovieStore::NO_MOVIE, -1);
+    movies.waitForLoads();
     
     //establish communication pipeline between FilmBox instances and the GUI
     setupGUIs();
     
     //lights
     setupLights();   //setup lights of the Oscar statuette
+    
+    //input recording and replay
+    setupInputRecorder();
+    
+    //metrics endpoint
+    setupMetrics();
+    
+    //GPU time of the render passes
+    gpuTimer.setup();
+    
+    //offscreen capture
+    setupCapture();
+    
+    //second display
+    isBoxLeaveRequested = false;
+    if(boxWindow) {
+        setupBoxDisplay();
+    }
+    
+    //soak test
+    if(isSoakTest) {
+        soakTest.start(ofToFloat(getArgument(arguments, "--soak")),
+                       currentGalaxy >= 0 ? galaxies.get(currentGalaxy).ringSize : 0, "soak-report.txt");
+    }
+    
+    //simulation: recorded, replayed, soak and captured runs step it once per frame so they are reproducible
+    bool lockstep = recorder.isRecording() || recorder.isReplaying() || soakTest.isRunning() || capture.isRunning();
+    simulation.start(camera.getPosition(), lockstep, &metrics);
+    movies.setSynchronous(lockstep);   //the same runs load the images of the boxes at the frame that needs them
+    
+    ofLogNotice("TextureCache") << "setup in " << ofGetElapsedTimef() - setupStart << " s, "
+                                << TextureCache::getHits() << " textures from the cache, "
+                                << TextureCache::getMisses() << " decoded";
+    
+    //the allocations of the frame loop are counted on this thread, the background threads are not tracked
+    AllocationTracker::trackThread(true);
 }
 
 
 //--------------------------------------------------------------
 void ofApp::update(){
     
+    AllocationTracker::setPhase(AllocationTracker::UPDATE);
+    
+    //frame timing
+    uint64_t now = ofGetSystemTimeMicros();
+    if(frameStartMicros != 0) {
+        metrics.frameTime.observe(now - frameStartMicros);
+    }
+    frameStartMicros = now;
+    
+    //input replay
+    if(recorder.isRecording() || recorder.isReplaying()) {
+        recorder.sampleFrame(ofGetFrameNum());
+    }
+    if(recorder.isReplaying()) {
+        replayInput();   //recorded events are sent before the frame is updated, as it happens with the real input
+    }
+    
+    //exit requested on the box display, applied here because its event arrives with the GL context of that window
+    if(isBoxLeaveRequested) {
+        isBoxLeaveRequested = false;
+        if(movieSelected != MovieStore::NO_MOVIE && !isBoxRotating()) {
+            leaveMovie();
+        }
+    }
+    
     //lights positions
     updatePositionLights();
     
     //model rotation
     modelRotation();   //180° model rotation on the y axis when Oscar view is activated
     
-    //camera movement
-    if(moveCameraEnabled) {   //if true, the camera moves to 'targetBoxPosition' position
-        moveCamera(targetBoxPosition);
+    //offscreen capture
+    if(capture.isRunning()) {
+        updateCapture();   //the camera is placed for the next frame of the capture
     }
     
-    //box rotation
-    if(rotateBoxRight || rotateBoxLeft) {
-        rotateMovieBox();
+    //camera movement, box rotation and ring scrolling: the latest state published by the simulation
+    if(!capture.isRunning()) {   //during the capture the camera is placed by updateCapture
+        simulation.update();
+        const Simulation::Snapshot & state = simulation.getSnapshot();
+        camera.setPosition(state.cameraPosition);
+        if(movieSelected != MovieStore::NO_MOVIE) {
+            movies.setRotation(movieSelected, state.boxRotation);
+        }
     }
     
+    //expansion of the clusters near the camera and visible arcs, the images decoded by the loader thread are uploaded
+    //a few per frame; the single-box shots of the capture place the camera in the origin, there the clusters keep the
+    //state of the last camera path instead of expanding around a box that is drawn alone
+    if(!capture.isRunning() || captureShot.type == FrameCapture::PATH) {
+        galaxies.update(camera.getPosition(), simulation.getSnapshot().scrollAngle, movies, movieSelected, ASSET_BUDGET);
+    }
+    movies.update(ASSET_BUDGET);
+    
+    //layout, projection, culling and picking for the next draw
+    AllocationTracker::setPhase(AllocationTracker::LAYOUT);
+    updateRenderList();
+    AllocationTracker::setPhase(AllocationTracker::UPDATE);
+    
     //trailer and soundtrack update of the currently selected movie box
-    if(movieSelected != NULL) {
-        movieSelected -> update();
+    if(movieSelected != MovieStore::NO_MOVIE) {
+        movies.getAssets(movieSelected).update();
+    }
+    
+    //soak test
+    if(soakTest.isRunning()) {
+        updateSoakTest();
     }
     
     //help
     showHelp();
     
-    //stop scrolling
-    if(scrollBoxEnable) {
-        scrollBoxEnable = false;
+    //metrics
+    if(metricsServer.isThreadRunning()) {
+        updateMetrics();
     }
+    
+    metrics.updateTime.observe(ofGetSystemTimeMicros() - frameStartMicros);
 }
 
 
 //--------------------------------------------------------------
 void ofApp::draw(){
-
-    //background
-    ofDisableDepthTest();   //disables depth test to have the image behind all other objects
-    backgroundImage.draw(ofPoint(0, 0), ofGetWidth(), ofGetHeight());   //background
-    ofEnableDepthTest();
     
-    camera.begin();
+    AllocationTracker::setPhase(AllocationTracker::DRAW);
+    drawStartMicros = ofGetSystemTimeMicros();
+    StateCache::invalidate();   //the GUI and the buffer swap may have changed the GL state since the last frame
     
-    //Oscar model and movies boxes
-    model.drawFaces();         //draws 3D model
-    drawBoxesAndSelection();   //draws movies boxes around the Oscar statuette and manages raycasting
+    //offscreen capture: the window is hidden, only the offscreen target is drawn
+    if(capture.isRunning()) {
+        if(isCaptureShotReady) {
+            drawCapture();
+        }
+        frameArena.reset();
+        AllocationTracker::endFrame();
+        StateCache::endFrame();
+        return;
+    }
     
-    camera.end();
+    gpuTimer.beginFrame();
+    
+    //Oscar model, movies boxes and galaxies
+    drawScene(ofGetWidth(), ofGetHeight());
     
     //GUI and FPS
-    ofDisableLighting();    //if lights are enabled, the GUI is illegible
-    ofDisableDepthTest();   //turning it off is useful for combining 3D scene with 2D overlays such as a control panel
+    AllocationTracker::setPhase(AllocationTracker::GUI);
+    gpuTimer.begin(GpuTimer::GUI);
+    StateCache::setLighting(false);    //if lights are enabled, the GUI is illegible
+    StateCache::setDepthTest(false);   //turning it off is useful for combining 3D scene with 2D overlays such as a
+                                       //control panel; the next frame enables both again when it needs them
     
     //the GUI to draw depends from the current view
     if(!isZoomingInsideBox) {
@@ -130,123 +263,385 @@ void ofApp::draw(){
         boxPanel.draw();
     }
     
-    font.drawString("FPS: " + ofToString((int)ofGetFrameRate()), 10, 20);   //write FPS
-    font.drawString(helpText, 10, ofGetHeight() - 40);                      //draw help
+    //the FPS text is formatted again only when the value changes
+    int fps = (int)ofGetFrameRate();
+    if(fps != lastFps) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "FPS: %d", fps);
+        fpsText.assign(buffer);
+        lastFps = fps;
+    }
+    
+    font.drawString(fpsText, 10, 20);                        //write FPS
+    font.drawString(gpuTimer.getSummary(), 10, 40);          //write GPU time of each pass
+    font.drawString(helpText, 10, ofGetHeight() - 40);       //draw help
+    
+    gpuTimer.end(GpuTimer::GUI);
     
-    ofEnableDepthTest();
-    ofEnableLighting();
+    metrics.drawTime.observe(ofGetSystemTimeMicros() - drawStartMicros);
+    
+    //the transient data of the frame is released
+    frameArena.reset();
+    AllocationTracker::endFrame();
+    StateCache::endFrame();
+}
+
+
+//--------------------------------------------------------------
+void ofApp::drawScene(float width, float height) {
     
+    //background
+    gpuTimer.begin(GpuTimer::BACKGROUND);
+    StateCache::setLighting(true);
+    StateCache::setDepthTest(false);   //disables depth test to have the image behind all other objects
+    backgroundImage.draw(ofPoint(0, 0), width, height);   //background
+    StateCache::setDepthTest(true);
+    gpuTimer.end(GpuTimer::BACKGROUND);
+    
+    camera.begin();
+    
+    //Oscar model in the center of each expanded cluster
+    gpuTimer.begin(GpuTimer::STATUETTE);
+    for(size_t g = 0; g < galaxies.size(); g++) {
+        if(galaxies.get(g).expanded) {
+            ofPushMatrix();
+            ofTranslate(galaxies.get(g).center);
+            model.drawFaces();   //draws 3D model
+            ofPopMatrix();
+        }
+    }
+    StateCache::invalidate();   //the model loader sets face culling of each mesh by itself
+    gpuTimer.end(GpuTimer::STATUETTE);
+    
+    //movies boxes and far clusters
+    drawBoxesAndSelection();   //draws movies boxes around the Oscar statuette and manages raycasting
+    galaxies.drawImpostors(renderList.hoveredGalaxy);
+    
+    camera.end();
 }
 
 
 //--------------------------------------------------------------
 void ofApp::exit() {
-    movieSelected = NULL;
-    delete movieSelected;
+    //soak test interrupted before its end
+    soakTest.finish();
+    
+    //offscreen capture interrupted before its end, the frames already rendered are saved
+    capture.finish();
+    
+    //metrics endpoint
+    metricsServer.stop();
+    
+    //simulation thread
+    simulation.stop();
+    
+    //per-frame stages
+    jobs.stop();
+    
+    //texture cache files not yet written
+    TextureCache::close();
+    
+    //GPU time of the render passes
+    ofLogNotice("GpuTimer") << gpuTimer.getSummary();
+    gpuTimer.clear();
+    
+    //heap allocations of the run, only in builds with OSCAR_TRACK_ALLOCATIONS defined
+    AllocationTracker::writeSummary();
+    ofLogNotice("FrameArena") << "high-water mark " << frameArena.getHighWater() << " bytes";
+    
+    //input recording and replay
+    if(!reportPath.empty()) {
+        recorder.writeReport(reportPath);
+    }
+    recorder.stop();
+    
+    movieSelected = MovieStore::NO_MOVIE;
+    
+    //meshes shared by all movie boxes
+    FilmBox::clearBoxes();
 }
 
 
 //--------------------------------------------------------------
 void ofApp::getData(string file) {
     data.open(file);
+    addCatalog(data);
     
-    //fill the movies vector with information retrieved from JSON file
-    movies.resize(data["movies"].size());
-    for(int i = 0; i < movies.size(); i++) {
-        movies[i].setId(data["movies"][i]["ID"].asString());   //uploads poster, trailer, and soundtrack for each movie
+    //catalogs of other years, one JSON file each
+    ofDirectory catalogs("catalogs");
+    if(catalogs.exists()) {
+        catalogs.allowExt("json");
+        catalogs.listDir();
+        catalogs.sort();
+        for(size_t i = 0; i < catalogs.size(); i++) {
+            ofxJSONElement catalog;
+            if(catalog.open(catalogs.getPath(i))) {
+                addCatalog(catalog);
+            }
+        }
     }
 }
 
 
 //--------------------------------------------------------------
-void ofApp::moveCamera(ofPoint target) {
-    float tweenValue = 0.3;
-    ofPoint startPos = camera.getPosition();   //initial camera position
-    ofPoint targetPos;                         //final camera position
-    int zPos;                                  //z axis value, it depends if the camera is zooming in or zooming out
-    int yPos = target.y;                       //y axis value, it depends if the Oscar View is activated or deactivated
-    ofVec3f lerpPos;                           //holds the tweened position
+void ofApp::addCatalog(ofxJSONElement & catalog) {
+    bool byCategory = getArgument(arguments, "--cluster-by") == "category";
     
-    if(isZoomingInsideBox) {
-        zPos = 56;
-    } else {
-        zPos = cameraOrigin.z;
+    //fill the movie store with information retrieved from JSON file, the assets are loaded later
+    for(int i = 0; i < catalog["movies"].size(); i++) {
+        Json::Value & movie = catalog["movies"][i];
+        
+        //cluster of the movie: its first award, or its year (movie year, catalog year, 2017 for the original catalog)
+        string name;
+        if(byCategory) {
+            name = movie["awards"].size() > 0 ? movie["awards"][0].asString() : "Other";
+        } else {
+            Json::Value & year = movie.isMember("year") ? movie["year"] : catalog["year"];
+            name = year.isNull() ? "2017" : (year.isString() ? year.asString() : ofToString(year.asInt()));
+        }
+        
+        int galaxy = galaxies.getGalaxy(name);
+        int ringSlot = galaxies.addMember(galaxy, movies.size());
+        movies.add(movie["ID"].asString(), galaxy, ringSlot);
     }
+}
+
+
+//--------------------------------------------------------------
+void ofApp::enterGalaxy(int galaxy) {
+    currentGalaxy = galaxy;
+    cameraOrigin = galaxies.get(galaxy).center + ofPoint(0, 0, 1000);
+    simulation.moveCamera(cameraOrigin);   //camera is moving, the cluster is expanded when it gets close
+}
+
+
+//--------------------------------------------------------------
+void ofApp::leaveGalaxy() {
+    currentGalaxy = -1;
+    cameraOrigin = galaxies.getOverviewPosition();
+    simulation.moveCamera(cameraOrigin);   //camera is moving, the cluster is collapsed when it gets far
+}
+
+
+//--------------------------------------------------------------
+void ofApp::selectMovie(MovieStore::MovieId id) {
+    movieSelected = id;   //movie box currently selected
+    isZoomingInsideBox = true;   //camera is zooming inside the selected movie box
+    simulation.resetBox();       //the rotations start from the front face
     
-    //update final camera position
-    targetPos = ofVec3f(target.x, yPos, zPos);
+    //with a box display, the box is opened there and this window keeps showing the universe
+    if(!boxWindow) {
+        const ofPoint & target = movies.getWorldPosition(id);
+        simulation.moveCamera(glm::vec3(target.x, target.y, 56));   //camera is moving inside the selected movie box
+        
+        //disable Oscar lights
+        enableOscarLights(false);
+        
+        //enable light inside selected movie box
+        const ofPoint & position = movies.getWorldPosition(id);
+        lightBox.setPosition(position);
+        lightBox.lookAt(ofPoint(position.x, position.y, position.z - 1)); //illuminates frontal face
+        StateCache::setLight(lightBox, true);
+    }
+    
+    //enable audio, the trailer and the soundtrack are opened only for the selected movie box
+    movies.getAssets(id).openMedia();
+    movies.getAssets(id).settingAudioControls(true);   //play soundtrack of the selected movie box
+    
+    //media counters restart with the new movie box
+    lastTrailerFrame = -1;
+    lastSoundtrackPosition = -1;
+    isSoundtrackStalled = false;
+}
+
+
+//--------------------------------------------------------------
+void ofApp::leaveMovie() {
+    isZoomingInsideBox = false;            //camera is not zooming in
+    simulation.moveCamera(cameraOrigin);   //camera is moving (it is zooming out)
+    simulation.resetBox();
     
-    //calculate the interpolated values
-    lerpPos.x = ofLerp(startPos.x, targetPos.x, tweenValue);
-    lerpPos.y = ofLerp(startPos.y, targetPos.y, tweenValue);
-    lerpPos.z = ofLerp(startPos.z, targetPos.z, tweenValue);
+    //enable Oscar lights
+    enableOscarLights(true);
     
-    camera.setPosition(lerpPos);   //updates camera position
+    //disable light of the selected movie box
+    StateCache::setLight(lightBox, false);
     
-    //when camera reaches the final position, it stops
-    if(abs(camera.getPosition().x - targetPos.x) < 0.01 &&
-       abs(camera.getPosition().y - targetPos.y) < 0.01 &&
-       abs(camera.getPosition().z - targetPos.z) < 0.01) {
-        
-        moveCameraEnabled = false;
+    FilmBox & assets = movies.getAssets(movieSelected);
+    movies.setRotation(movieSelected, 0);      //resets rotation movie box
+    if(assets.getTrailer().isPlaying()) {      //pause the video when it isn't paused before exit the box
+        assets.settingVideoControls();         //needed to solve a bug
     }
+    assets.settingAudioControls(false);        //stops soundtrack of the selected movie box
+    assets.getTrailer().stop();                //stops trailer of the selected movie box
+    assets.closeMedia();                       //the decoders are released, the textures stay for the ring
+    
+    movieSelected = MovieStore::NO_MOVIE;   //when the camera is outside movies boxes, no movie is selected
 }
 
 
 //--------------------------------------------------------------
-void ofApp::rotateMovieBox() {
-    //gradual rotation of the selected movie box
-    if(rotateBoxRight) {   //if true, the movie box rotates 90° to show the right side of the box
-        movieSelected -> rotateBox('r');
+void ofApp::updateRenderList() {
+    const vector<GalaxyMap::RingEntry> & activeMovies = galaxies.getActiveMovies();   //visible arcs of expanded clusters
+    size_t count = activeMovies.size();
+    RenderList & list = renderList;
+    size_t chunks = (count + LAYOUT_CHUNK - 1) / LAYOUT_CHUNK;
+    
+    //inputs and scratch arrays of the stages live in the frame arena, released at the end of the draw
+    LayoutFrame * frame = new (frameArena.allocate<LayoutFrame>(1)) LayoutFrame();
+    frame->activeMovies = activeMovies.data();
+    frame->count = count;
+    frame->visibility = frameArena.allocate<uint8_t>(count);
+    frame->hitDistances = frameArena.allocate<float>(chunks);
+    frame->hits = frameArena.allocate<MovieStore::MovieId>(chunks);
+    for(size_t c = 0; c < chunks; c++) {   //the arena memory is not cleared, a chunk that is not run hits nothing
+        frame->hitDistances[c] = numeric_limits<float>::max();
+        frame->hits[c] = MovieStore::NO_MOVIE;
+    }
+    
+    //camera and mouse data are read once on this thread, the workers only read the copies
+    ofRectangle viewport = ofGetCurrentViewport();
+    frame->viewport = glm::vec4(viewport.x, viewport.y, viewport.width, viewport.height);
+    frame->modelViewProjection = camera.getModelViewProjectionMatrix(viewport);
+    frame->isVFlipped = camera.isVFlipped();
+    frame->rayOrigin = mousepicker.getRay().getOrigin();
+    frame->rayDirection = mousepicker.getRay().getDirection();
+    frame->startAngle = simulation.getSnapshot().scrollAngle;
+    frame->radius = glm::length(glm::vec3(FilmBox::getDimensionBox())) / 2;   //bounding sphere of a movie box
+    
+    //frustum planes extracted from the rows of the model view projection matrix
+    const glm::mat4 & modelViewProjection = frame->modelViewProjection;
+    for(int axis = 0; axis < 3; axis++) {
+        glm::vec4 row = glm::vec4(modelViewProjection[0][axis], modelViewProjection[1][axis],
+                                  modelViewProjection[2][axis], modelViewProjection[3][axis]);
+        glm::vec4 w = glm::vec4(modelViewProjection[0][3], modelViewProjection[1][3],
+                                modelViewProjection[2][3], modelViewProjection[3][3]);
+        frame->planes[axis * 2] = w + row;
+        frame->planes[axis * 2 + 1] = w - row;
+    }
+    for(auto & plane : frame->planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    
+    //the job captures two pointers, small enough to be stored inside std::function without a heap allocation
+    jobs.parallelFor(count, LAYOUT_CHUNK, [this, frame](size_t begin, size_t end) {
+        vector<ofPoint> & worldPositions = movies.getWorldPositions();
+        vector<ofPoint> & screenPositions = movies.getScreenPositions();
+        float nearestDistance = numeric_limits<float>::max();
+        MovieStore::MovieId nearest = MovieStore::NO_MOVIE;
+        float hitDistance;
         
-        if(movieSelected -> getRotationStep() == 90) {   //when the movie box is rotated 90°, the rotation stops
-            movieSelected -> setRotationStep(0);
-            rotateBoxRight = false;
+        for(size_t k = begin; k < end; k++) {
+            MovieStore::MovieId i = frame->activeMovies[k].id;
+            if(!movies.isResident(i)) {   //the assets of the box are not loaded yet
+                frame->visibility[k] = false;
+                continue;
+            }
+            
+            //layout: the movies are uniformly distributed around an immaginary circle centered in their cluster
+            const GalaxyMap::Galaxy & galaxy = galaxies.get(movies.getGalaxy(i));
+            float angle = ofDegToRad(frame->startAngle + frame->activeMovies[k].position * galaxy.angleOffset);
+            worldPositions[i] = galaxy.center + ofPoint(cos(angle) * distance, sin(angle) * distance, 0);   //box position
+                                                                                                         //in World Space
+            glm::vec3 position = worldPositions[i];
+            
+            //projection: same computation of ofCamera::worldToScreen
+            glm::vec4 clip = frame->modelViewProjection * glm::vec4(position, 1.0);
+            glm::vec3 ndc = glm::vec3(clip) / clip.w;
+            if(frame->isVFlipped) {
+                ndc.y = -ndc.y;
+            }
+            screenPositions[i] = ofPoint((ndc.x + 1.f) / 2.f * frame->viewport.z + frame->viewport.x,
+                                         (1.f - ndc.y) / 2.f * frame->viewport.w + frame->viewport.y,
+                                         ndc.z);   //box position in Screen Space
+            
+            //frustum classification of the bounding sphere
+            bool inside = true;
+            for(int p = 0; p < 6 && inside; p++) {
+                inside = glm::dot(glm::vec3(frame->planes[p]), position) + frame->planes[p].w > -frame->radius;
+            }
+            frame->visibility[k] = inside;
+            
+            //raycasting: check if the i-th box is now pointed by the mouse, the nearest box is selected
+            if(movies.intersects(i, frame->rayOrigin, frame->rayDirection, hitDistance) &&
+               hitDistance < nearestDistance) {
+                nearestDistance = hitDistance;
+                nearest = i;
+            }
         }
-    } else if(rotateBoxLeft) {   //if true, the selected movie box rotates 90° to show the left side of the box
-        movieSelected -> rotateBox('l');
-        
-        if(movieSelected -> getRotationStep() == 90) {   //when the movie box is rotated 90°, the rotation stops
-            movieSelected -> setRotationStep(0);
-            rotateBoxLeft = false;
+        frame->hitDistances[begin / LAYOUT_CHUNK] = nearestDistance;
+        frame->hits[begin / LAYOUT_CHUNK] = nearest;
+    });
+    
+    //the visible boxes are collected in drawing order, the items vector keeps its capacity between frames
+    vector<ofPoint> & worldPositions = movies.getWorldPositions();
+    list.items.clear();
+    for(size_t k = 0; k < count; k++) {
+        if(frame->visibility[k]) {
+            MovieStore::MovieId i = activeMovies[k].id;
+            RenderItem item;
+            item.id = i;
+            item.position = worldPositions[i];
+            item.rotation = movies.getRotation(i);
+            list.items.push_back(item);
+        }
+    }
+    
+    //nearest box hit by the ray among all chunks
+    list.hovered = MovieStore::NO_MOVIE;
+    list.hoveredDistance = numeric_limits<float>::max();
+    for(size_t c = 0; c < chunks; c++) {
+        if(frame->hits[c] != MovieStore::NO_MOVIE && frame->hitDistances[c] < list.hoveredDistance) {
+            list.hoveredDistance = frame->hitDistances[c];
+            list.hovered = frame->hits[c];
         }
     }
+    
+    //far clusters are picked on this thread, they are few
+    list.hoveredGalaxy = galaxies.intersects(frame->rayOrigin, frame->rayDirection);
+    
+    hoveredGalaxy = list.hoveredGalaxy;
+    foundIntersection = list.hovered != MovieStore::NO_MOVIE;   //it was found an intersection
+    if(foundIntersection) {
+        indexIntersectedPrimitive = list.hovered;   //saves the index of the selected box
+        dist = list.hoveredDistance;
+    }
 }
 
 
 //--------------------------------------------------------------
 void ofApp::drawBoxesAndSelection() {
-    foundIntersection = false;
-    
+    const RenderList & list = renderList;
     
-    for(int i = 0; i < movies.size(); i++) {
-        movies[i].setWorldPosBox(cos(ofDegToRad(angle)) * distance,
-                                 sin(ofDegToRad(angle)) * distance, 0);                  //box position in World Space
-        movies[i].setScreenPosBox(camera.worldToScreen(movies[i].getWorldPosBox()).x,
-                                  camera.worldToScreen(movies[i].getWorldPosBox()).y);   //box position in Screen Space
-
-        movies[i].display();   //draw movies boxes
-        
-        angle += angleOffset;
-        
-        //raycasting: check if the i-th box is now pointed by the mouse
-        intersects = mousepicker.getRay().intersectsPrimitive(movies[i].getBox(), baricentricCoordinates, dist, surfaceNormal);
-        if(intersects) { //if it's true, the ray hit a box
-            foundIntersection = true;   //it was found an intersection
-            indexIntersectedPrimitive = i;   //saves the index of the selected box
-        }
+    //the draw only consumes the render list produced by updateRenderList
+    gpuTimer.begin(GpuTimer::BOXES);
+    for(auto & item : list.items) {
+        movies.getAssets(item.id).display(item.position, item.rotation);   //draw movies boxes
     }
+    gpuTimer.end(GpuTimer::BOXES);
     
-    //bool intersectsPrimitive(const of3dPrimitive& primitive,  glm::vec2 & baricentricCoords, float & distance, glm::vec3 & intNormal)
-    
-    angle = 0.f + stepScrollBox;
+    gpuTimer.begin(GpuTimer::TRAILER);
+    for(auto & item : list.items) {
+        movies.getAssets(item.id).displayTrailer(item.position, item.rotation);   //draw trailers
+    }
+    for(auto & item : list.items) {
+        movies.getAssets(item.id).displayPlayIcon(item.position, item.rotation);  //draw play icons of paused trailers
+    }
+    StateCache::setCullFace(false);   //the play icons leave face culling enabled
+    gpuTimer.end(GpuTimer::TRAILER);
     
     //if the mouse is pointing a movie box, it is highlighted
-    if(foundIntersection && movieSelected == NULL) {   //selection is visible only when no movie box has been selected
+    bool isHighlighted = list.hovered != MovieStore::NO_MOVIE &&
+                         movieSelected == MovieStore::NO_MOVIE &&   //selection is visible only when no movie box
+                         !capture.isRunning();                      //has been selected, and never in the capture
+    if(isHighlighted) {
         ofPushStyle();
+        ofPushMatrix();
         glPointSize(5);   //magnifies vertex size
         ofSetColor(ofColor::gold);
-        movies[indexIntersectedPrimitive].getBox().drawVertices();   //draws vertices of selected movie box
+        ofTranslate(movies.getWorldPosition(list.hovered));
+        FilmBox::getBox().drawVertices();   //draws vertices of selected movie box
+        ofPopMatrix();
         ofPopStyle();
     }
 }
@@ -260,83 +655,103 @@ void ofApp::setupLights() {
     lFace.setDiffuseColor(ofColor::white);
     lFace.setSpecularColor(ofColor::white);
     lFace.setPointLight();
-    lFace.enable();
     
     //Front body light
     lBody.setAmbientColor(ofColor::white);
     lBody.setDiffuseColor(ofColor::white);
     lBody.setSpecularColor(ofColor::white);
     lBody.setPointLight();
-    lBody.enable();
     
     //Right face light
     lHeadRight.setAmbientColor(ofColor::white);
     lHeadRight.setDiffuseColor(ofColor::white);
     lHeadRight.setSpecularColor(ofColor::white);
     lHeadRight.setPointLight();
-    lHeadRight.enable();
     
     //Left face light
     lHeadLeft.setAmbientColor(ofColor::white);
     lHeadLeft.setDiffuseColor(ofColor::white);
     lHeadLeft.setSpecularColor(ofColor::white);
     lHeadLeft.setPointLight();
-    lHeadLeft.enable();
     
     //Right body light
     lBodyRight.setAmbientColor(ofColor::white);
     lBodyRight.setDiffuseColor(ofColor::white);
     lBodyRight.setSpecularColor(ofColor::white);
     lBodyRight.setPointLight();
-    lBodyRight.enable();
     
     //Left body light
     lBodyLeft.setAmbientColor(ofColor::white);
     lBodyLeft.setDiffuseColor(ofColor::white);
     lBodyLeft.setSpecularColor(ofColor::white);
     lBodyLeft.setPointLight();
-    lBodyLeft.enable();
     
     //Right base light
     lBase.setAmbientColor(ofColor::white);
     lBase.setDiffuseColor(ofColor::white);
     lBase.setSpecularColor(ofColor::white);
     lBase.setPointLight();
-    lBase.enable();
+    
+    //the lights of the statuette are turned on together
+    enableOscarLights(true);
     
     //Internal box light
+    setupBoxLight();
+    StateCache::setLight(lightBox, false);
+}
+
+
+//--------------------------------------------------------------
+void ofApp::setupBoxLight() {
     lightBox.setAmbientColor(ofColor::white);
     lightBox.setDiffuseColor(ofColor::white);
     lightBox.setSpecularColor(ofColor::white);
     lightBox.setSpotlight();
     lightBox.setSpotlightCutOff(60.f);
-    lightBox.disable();
+}
+
+
+//--------------------------------------------------------------
+void ofApp::enableOscarLights(bool b) {
+    ofLight * lights[] = {&lFace, &lBody, &lHeadRight, &lHeadLeft, &lBodyRight, &lBodyLeft, &lBase};
+    for(auto light : lights) {
+        StateCache::setLight(*light, b);   //the lights already in the requested state are skipped
+    }
 }
 
 
 //--------------------------------------------------------------
 void ofApp::updatePositionLights() {
-    lFace.setPosition(0, 160, 300);
-    lBody.setPosition(0, 0, 300);
-    lHeadRight.setPosition(100, 250, 100);
-    lHeadLeft.setPosition(-100, 250, 100);
-    lBodyRight.setPosition(150, 30, 50);
-    lBodyLeft.setPosition(-150, 30, 50);
-    lBase.setPosition(200, -200, 100);
+    //the lights follow the Oscar statuette of the current cluster
+    ofPoint origin = currentGalaxy >= 0 ? galaxies.get(currentGalaxy).center : ofPoint(0, 0, 0);
+    
+    lFace.setPosition(origin + ofPoint(0, 160, 300));
+    lBody.setPosition(origin + ofPoint(0, 0, 300));
+    lHeadRight.setPosition(origin + ofPoint(100, 250, 100));
+    lHeadLeft.setPosition(origin + ofPoint(-100, 250, 100));
+    lBodyRight.setPosition(origin + ofPoint(150, 30, 50));
+    lBodyLeft.setPosition(origin + ofPoint(-150, 30, 50));
+    lBase.setPosition(origin + ofPoint(200, -200, 100));
 }
 
 
 //--------------------------------------------------------------
 void ofApp::showHelp(){
     //help text shows only commands currently available based on the current position of the camera
+    const char * text = "";
     if(help) {
         if(isZoomingInsideBox) {
-            helpText = "Press RIGHT ARROW or LEFT ARROW to rotate the box \nPress 'Q' to exit from the box";
-        } else {
-            helpText = "";
+            text = "Press RIGHT ARROW or LEFT ARROW to rotate the box \nPress 'Q' to exit from the box";
+        } else if(currentGalaxy < 0) {
+            text = "Click on a galaxy to reach it";
+        } else if(galaxies.size() > 1) {
+            text = "Press 'Q' to go back to all galaxies";
         }
-    } else {
-        helpText = "";
+    }
+    
+    //the string is assigned only when the text changes, not at every frame
+    if(helpText != text) {
+        helpText.assign(text);
     }
 }
 
@@ -348,6 +763,13 @@ void ofApp::modelRotation() {
         isModelRotated = false;
     }
 }
+
+
+//--------------------------------------------------------------
+bool ofApp::isBoxRotating() {
+    //a rotation just requested is not in the snapshot until the simulation applies it
+    return simulation.getSnapshot().isBoxRotating || simulation.isBehind();
+}
 //--------------------------------------------------------------
 
 
@@ -364,12 +786,11 @@ void ofApp::setupGUIs(){
     
     //PANELS
     //boxPanel
-    boxPanel.loadFont("Ubuntu-Regular.ttf", 14);
+    ofxGuiSetFont("Ubuntu-Regular.ttf", 14);   //the glyph atlas is built once and shared by both panels
     boxPanel.setup(boxGroup);
     boxPanel.setPosition(ofPoint(boxPanel.getPosition().x, boxPanel.getPosition().y + 20, boxPanel.getPosition().z));
     
     //universePanel
-    universePanel.loadFont("Ubuntu-Regular.ttf", 14);
     universePanel.setup(wrapperGroupUni);
     universePanel.setPosition(boxPanel.getPosition());
     
@@ -382,48 +803,477 @@ void ofApp::setupGUIs(){
 
 
 //--------------------------------------------------------------
-void ofApp::keyReleased(int key){
-    //reset camera position
-    if(key == 'q' && movieSelected != NULL &&
-        movieSelected -> getRotationStep() == 0) {   //during the rotation of the selected movie box,
-                                                     //the camera position is not reset
-        targetBoxPosition = cameraOrigin;
+void ofApp::setupInputRecorder() {
+    string recordPath = getArgument(arguments, "--record");
+    string replayPath = getArgument(arguments, "--replay");
+    
+    if(!replayPath.empty()) {
+        if(recorder.startReplay(replayPath, boxGroup)) {
+            reportPath = replayPath + ".report.txt";
+            
+            //deterministic clock: every frame advances the time by the same step, as fast as possible
+            ofSetTimeModeFixedRate(ofGetFixedStepForFps(60));
+            ofSetVerticalSync(false);
+            ofSetFrameRate(0);
+        }
+    } else if(!recordPath.empty()) {
+        if(recorder.startRecording(recordPath, boxGroup)) {
+            reportPath = recordPath + ".report.txt";
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+void ofApp::replayInput() {
+    InputRecorder::InputEvent event;
+    
+    recorder.setDispatching(true);   //the events sent now are not ignored by the input callbacks
+    while(recorder.popEvent(ofGetFrameNum(), event)) {
+        if(event.type == InputRecorder::MOUSE_MOVED) {
+            mouseX = event.x;
+            mouseY = event.y;
+            mouseMoved(event.x, event.y);
+        } else if(event.type == InputRecorder::MOUSE_RELEASED) {
+            mouseX = event.x;
+            mouseY = event.y;
+            mouseReleased(event.x, event.y, event.button);
+        } else if(event.type == InputRecorder::MOUSE_SCROLLED) {
+            mouseScrolled(event.x, event.y, 0.f, event.scroll);
+        } else if(event.type == InputRecorder::KEY_RELEASED) {
+            keyReleased(event.x);
+        } else if(event.type == InputRecorder::PARAMETER) {
+            recorder.applyParameter(event);
+        }
+    }
+    recorder.setDispatching(false);
+    
+    //when the recorded session is over, the report is written by exit()
+    if(recorder.isReplayOver(ofGetFrameNum())) {
+        ofExit();
+    }
+}
+
+
+//--------------------------------------------------------------
+void ofApp::updateSoakTest() {
+    soakTest.sample();
+    
+    if(soakTest.isOver()) {
+        ofExit(soakTest.finish() ? 0 : 1);   //a leak makes the process fail
+        return;
+    }
+    
+    bool idle = !simulation.getSnapshot().isCameraMoving && !simulation.isBehind() && !isBoxRotating() &&
+                galaxies.isPagingDone() && !movies.isLoading();
+    const vector<GalaxyMap::RingEntry> & activeMovies = galaxies.getActiveMovies();
+    bool isSelected = movieSelected != MovieStore::NO_MOVIE;   //a box whose assets were not resident is not entered,
+                                                               //the other actions of its cycle are skipped
+    switch(soakTest.update(idle)) {
+        case SoakTest::SELECT:
+            if(!activeMovies.empty()) {
+                MovieStore::MovieId id = activeMovies[soakTest.getCurrentMovie() % activeMovies.size()].id;
+                if(movies.isResident(id)) {
+                    selectMovie(id);
+                }
+            }
+            break;
+        case SoakTest::ROTATE_RIGHT:
+            if(isSelected) {
+                simulation.rotateBox(1, FilmBox::getRotationSpeed());
+            }
+            break;
+        case SoakTest::TOGGLE_TRAILER:
+            if(isSelected) {
+                movies.getAssets(movieSelected).settingVideoControls();
+            }
+            break;
+        case SoakTest::LEAVE:
+            if(isSelected) {
+                leaveMovie();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+
+//--------------------------------------------------------------
+void ofApp::setupMetrics() {
+    frameStartMicros = 0;
+    drawStartMicros = 0;
+    lastTrailerFrame = -1;
+    lastSoundtrackPosition = -1;
+    lastSoundtrackAdvance = 0;
+    isSoundtrackStalled = false;
+    
+    string port = getArgument(arguments, "--metrics-port");
+    if(port.empty()) {
+        return;
+    }
+    
+    metrics.setMovieIds(movies.getIds());   //movie IDs are written before the server thread starts, then they are only read
+    
+    metricsServer.start(&metrics, ofToInt(port));
+}
+
+
+//--------------------------------------------------------------
+void ofApp::updateMetrics() {
+    //current view
+    metrics.view.store(isZoomingInsideBox ? Metrics::INSIDE_BOX : Metrics::UNIVERSE, std::memory_order_relaxed);
+    metrics.selectedMovie.store(movieSelected, std::memory_order_relaxed);
+    
+    //GL objects counted where the application allocates and releases them, no GL name is probed
+    metrics.liveTextures.store(ProcessStats::getAllocatedTextures(), std::memory_order_relaxed);
+    metrics.liveBuffers.store(ProcessStats::getAllocatedBuffers(), std::memory_order_relaxed);
+    
+    //GL state calls sent to the driver and skipped by the cache
+    metrics.stateCallsIssued.store(StateCache::getIssuedTotal(), std::memory_order_relaxed);
+    metrics.stateCallsSuppressed.store(StateCache::getSuppressedTotal(), std::memory_order_relaxed);
+    
+    if(movieSelected == MovieStore::NO_MOVIE) {
+        return;
+    }
+    
+    //trailer decoding: a jump of the frame number means that the decoder skipped frames
+    ofVideoPlayer & trailer = movies.getAssets(movieSelected).getTrailer();
+    if(trailer.isPlaying() && trailer.isFrameNew()) {
+        int frame = trailer.getCurrentFrame();
+        metrics.trailerDecodedFrames.fetch_add(1, std::memory_order_relaxed);
+        if(lastTrailerFrame >= 0 && frame > lastTrailerFrame + 1) {
+            metrics.trailerDroppedFrames.fetch_add(frame - lastTrailerFrame - 1, std::memory_order_relaxed);
+        }
+        lastTrailerFrame = frame;
+    }
+    
+    //soundtrack: ofSoundPlayer does not expose underruns, a playing soundtrack whose position does not advance
+    //for more than 100 ms is counted as one
+    ofSoundPlayer & soundtrack = movies.getAssets(movieSelected).getSoundtrack();
+    if(soundtrack.isPlaying() && !trailer.isPlaying()) {
+        int position = soundtrack.getPositionMS();
+        uint64_t now = ofGetSystemTimeMicros();
+        if(position != lastSoundtrackPosition) {
+            lastSoundtrackPosition = position;
+            lastSoundtrackAdvance = now;
+            isSoundtrackStalled = false;
+        } else if(!isSoundtrackStalled && now - lastSoundtrackAdvance > 100000) {
+            metrics.audioUnderruns.fetch_add(1, std::memory_order_relaxed);
+            isSoundtrackStalled = true;
+        }
+    } else {
+        lastSoundtrackPosition = -1;
+    }
+}
+
+
+//--------------------------------------------------------------
+void ofApp::setupBoxDisplay() {
+    isBoxDisplayLightReady = false;
+    
+    //the window shares the GL context of the main window, so it draws the same textures, videos and meshes; it is
+    //drawn in the same loop iteration, right after the main window, with the state of the same update
+    ofAddListener(boxWindow -> events().draw, this, &ofApp::drawBoxDisplay);
+    ofAddListener(boxWindow -> events().mouseReleased, this, &ofApp::boxDisplayMouseReleased);
+}
+
+
+//--------------------------------------------------------------
+void ofApp::drawBoxDisplay(ofEventArgs & args) {
+    //the GL state of this context is not the one cached for the main window
+    StateCache::invalidate();
+    
+    //background
+    StateCache::setDepthTest(false);
+    backgroundImage.draw(ofPoint(0, 0), ofGetWidth(), ofGetHeight());
+    StateCache::setDepthTest(true);
+    
+    //the opened box is seen from inside, otherwise the box pointed in the universe is seen from outside
+    bool isOpened = movieSelected != MovieStore::NO_MOVIE;
+    MovieStore::MovieId id = isOpened ? movieSelected : renderList.hovered;
+    if(id == MovieStore::NO_MOVIE || !movies.isResident(id)) {
+        StateCache::invalidate();
+        return;
+    }
+    
+    const ofPoint & position = movies.getWorldPosition(id);
+    boxCamera.setPosition(position.x, position.y, isOpened ? 56 : position.z + 300);
+    boxCamera.lookAt(position);
+    
+    boxCamera.begin();
+    
+    //the lights are GL state of each context, the one of this window is set up here
+    if(!isBoxDisplayLightReady) {
+        setupBoxLight();
+        isBoxDisplayLightReady = true;
+    }
+    StateCache::setLighting(true);
+    lightBox.setPosition(boxCamera.getPosition());
+    lightBox.lookAt(ofPoint(position.x, position.y, position.z - 1));   //illuminates frontal face
+    StateCache::setLight(lightBox, true);
+    
+    movies.getAssets(id).display(position, movies.getRotation(id));
+    movies.getAssets(id).displayTrailer(position, movies.getRotation(id));
+    movies.getAssets(id).displayPlayIcon(position, movies.getRotation(id));
+    StateCache::setCullFace(false);
+    
+    //the enabled flag of the light is shared with the main window, which must find it as it left it
+    StateCache::setLight(lightBox, false);
+    boxCamera.end();
+    StateCache::setLighting(false);
+    
+    //a touch screen has no arrow keys, the opened box is rotated and left with buttons
+    if(isOpened) {
+        StateCache::setDepthTest(false);
+        drawBoxDisplayButtons();
+    }
+    StateCache::invalidate();   //back to the main window
+}
+
+
+//--------------------------------------------------------------
+void ofApp::drawBoxDisplayButtons() {
+    const char * labels[BOX_DISPLAY_BUTTONS] = {"<", ">", "EXIT"};
+    bool isEnabled = !isBoxRotating();   //the buttons do nothing while the box is rotating
+    
+    for(int b = 0; b < BOX_DISPLAY_BUTTONS; b++) {
+        ofRectangle area = getBoxDisplayButton((BoxDisplayButton)b);
+        ofFill();
+        ofSetColor(0, 0, 0, 160);
+        ofDrawRectangle(area);
+        ofNoFill();
+        ofSetColor(isEnabled ? ofColor(212, 175, 55) : ofColor(90));   //gold, grey while rotating
+        ofDrawRectangle(area);
+        
+        ofRectangle text = font.getStringBoundingBox(labels[b], 0, 0);
+        font.drawString(labels[b], area.getCenter().x - text.getCenter().x, area.getCenter().y - text.getCenter().y);
+    }
+    ofFill();
+    ofSetColor(255);
+}
+
+
+//--------------------------------------------------------------
+ofRectangle ofApp::getBoxDisplayButton(BoxDisplayButton button) {
+    //the buttons are large enough for a finger, along the bottom edge of the box display: rotate left on the left,
+    //rotate right on the right and exit in the middle
+    float size = max(80.f, boxWindow -> getHeight() * 0.1f);
+    float margin = size * 0.25f;
+    float y = boxWindow -> getHeight() - size - margin;
+    switch(button) {
+        case ROTATE_LEFT: return ofRectangle(margin, y, size, size);
+        case ROTATE_RIGHT: return ofRectangle(boxWindow -> getWidth() - size - margin, y, size, size);
+        default: return ofRectangle((boxWindow -> getWidth() - size * 2) / 2, y, size * 2, size);
+    }
+}
+
+
+//--------------------------------------------------------------
+void ofApp::boxDisplayMouseReleased(ofMouseEventArgs & args) {
+    if(movieSelected == MovieStore::NO_MOVIE) {
+        return;
+    }
+    
+    //the buttons act as the arrow keys and 'Q' of the main window, only when the previous rotation is over
+    if(getBoxDisplayButton(ROTATE_LEFT).inside(args.x, args.y)) {
+        if(!isBoxRotating()) {
+            simulation.rotateBox(-1, FilmBox::getRotationSpeed());
+        }
+        return;
+    }
+    if(getBoxDisplayButton(ROTATE_RIGHT).inside(args.x, args.y)) {
+        if(!isBoxRotating()) {
+            simulation.rotateBox(1, FilmBox::getRotationSpeed());
+        }
+        return;
+    }
+    if(getBoxDisplayButton(LEAVE_BOX).inside(args.x, args.y)) {
+        isBoxLeaveRequested = true;   //the movie is left by the next update of the main window
+        return;
+    }
+    
+    //the trailer of the opened box is played or paused by touching it
+    ofRectangle viewport(0, 0, boxWindow -> getWidth(), boxWindow -> getHeight());
+    if(isOnTrailer(boxCamera, viewport, args.x, args.y)) {
+        movies.getAssets(movieSelected).settingVideoControls();
+    }
+}
+
+
+//--------------------------------------------------------------
+void ofApp::setupCapture() {
+    hasCaptureShot = false;
+    isCaptureShotReady = false;
+    captureShot.type = FrameCapture::PATH;   //no single-box shot is in progress
+    captureMovie = MovieStore::NO_MOVIE;
+    isCaptureMovieAcquired = false;
+    
+    string directory = getArgument(arguments, "--capture");
+    if(directory.empty()) {
+        return;
+    }
+    
+    //resolution of the frames, independent from the window
+    vector<string> size = ofSplitString(getArgument(arguments, "--capture-size"), "x");
+    int width = size.size() == 2 ? ofToInt(size[0]) : 1920;
+    int height = size.size() == 2 ? ofToInt(size[1]) : 1080;
+    
+    vector<string> galaxyNames;
+    for(size_t g = 0; g < galaxies.size(); g++) {
+        galaxyNames.push_back(galaxies.get(g).name);
+    }
+    
+    if(capture.start(directory, width, height, movies.getIds(), galaxyNames)) {
+        //the projection and the culling of the frame stages use the aspect ratio of the frames
+        camera.setForceAspectRatio(true);
+        camera.setAspectRatio(width / (float)height);
         
-        isZoomingInsideBox = false;   //camera is not zooming in
-        moveCameraEnabled = true;     //camera is moving (it is zooming out)
+        //deterministic clock, as fast as the encoders allow
+        ofSetTimeModeFixedRate(ofGetFixedStepForFps(60));
+        ofSetVerticalSync(false);
+        ofSetFrameRate(0);
+    }
+}
+
+
+//--------------------------------------------------------------
+void ofApp::updateCapture() {
+    capture.poll();   //the frames already read back by the GPU are sent to the encoders
+    
+    isCaptureShotReady = false;
+    if(!capture.isReady()) {   //the encoders are behind, no frame is drawn until they catch up
+        return;
+    }
+    
+    if(!hasCaptureShot) {
+        if(!capture.getNextShot(captureShot)) {
+            releaseCaptureMovie();
+            capture.finish();
+            ofExit();
+            return;
+        }
+        hasCaptureShot = true;
+    }
+    
+    if(captureShot.type == FrameCapture::PATH) {
+        releaseCaptureMovie();
         
-        //enable Oscar lights
-        lFace.enable();
-        lBody.enable();
-        lHeadRight.enable();
-        lHeadLeft.enable();
-        lBodyRight.enable();
-        lBodyLeft.enable();
-        lBase.enable();
+        //orbit in front of the galaxy, the boxes are placed by the usual frame stages
+        const GalaxyMap::Galaxy & galaxy = galaxies.get(captureShot.galaxy);
+        float angle = ofDegToRad(ofLerp(-60, 60, captureShot.t));
+        camera.setPosition(galaxy.center + ofPoint(sin(angle), 0, cos(angle)) * 1000);
+        camera.lookAt(galaxy.center);
+        currentGalaxy = captureShot.galaxy;
         
-        //disable light of the selected movie box
-        lightBox.disable();
+        StateCache::setLight(lightBox, false);   //the capture places the lights at every frame, the cache skips them
+        enableOscarLights(true);
         
-        movieSelected -> setRotationBox(0);               //resets rotation movie box
-        if(movieSelected -> getTrailer().isPlaying()) {   //pause the video when it isn't paused before exit the box
-            movieSelected -> settingVideoControls();      //needed to solve a bug
+        //the frame is drawn when all boxes of the galaxy are loaded
+        isCaptureShotReady = galaxy.expanded && galaxies.isPagingDone() && !movies.isLoading();
+    } else {
+        if(captureShot.movie != captureMovie) {
+            releaseCaptureMovie();
+            captureMovie = captureShot.movie;
+            isCaptureMovieAcquired = !movies.isAcquired(captureMovie);
+            movies.acquireAssets(captureMovie);
         }
-        movieSelected -> settingAudioControls(false);     //stops soundtrack of the selected movie box
-        movieSelected -> getTrailer().stop();             //stops trailer of the selected movie box
+        if(!movies.isResident(captureMovie)) {   //the images of the box are still being loaded
+            return;
+        }
+        movies.getAssets(captureMovie).openMedia();   //the inner faces show the trailer
+        movies.getAssets(captureMovie).update();
+        
+        //the box is drawn alone in the origin, seen from outside or from inside like in the application
+        camera.setPosition(0, 0, captureShot.type == FrameCapture::OUTER ? 300 : 56);
+        camera.lookAt(ofPoint(0, 0, 0));
         
+        enableOscarLights(false);
+        lightBox.setPosition(0, 0, 0);
+        lightBox.lookAt(ofPoint(0, 0, -1));   //illuminates frontal face
+        StateCache::setLight(lightBox, true);
         
-        movieSelected = NULL;   //when the camera is outside movies boxes, the pointer points to NULL
+        isCaptureShotReady = true;
+    }
+}
+
+
+//--------------------------------------------------------------
+void ofApp::drawCapture() {
+    capture.begin();
+    
+    if(captureShot.type == FrameCapture::PATH) {
+        drawScene(capture.getWidth(), capture.getHeight());
+    } else {
+        StateCache::setDepthTest(false);
+        backgroundImage.draw(ofPoint(0, 0), capture.getWidth(), capture.getHeight());
+        StateCache::setDepthTest(true);
+        
+        camera.begin();
+        movies.getAssets(captureMovie).display(ofPoint(0, 0, 0), max(0, captureShot.face) * 90);
+        movies.getAssets(captureMovie).displayTrailer(ofPoint(0, 0, 0), max(0, captureShot.face) * 90);
+        movies.getAssets(captureMovie).displayPlayIcon(ofPoint(0, 0, 0), max(0, captureShot.face) * 90);
+        StateCache::setCullFace(false);
+        camera.end();
+    }
+    
+    capture.end();
+    capture.readback(captureShot.file);   //the PNG is written later by the encoders
+    
+    hasCaptureShot = false;
+    isCaptureShotReady = false;
+}
+
+
+//--------------------------------------------------------------
+void ofApp::releaseCaptureMovie() {
+    //the trailer and the soundtrack are closed, the images stay loaded if the movie is also on a ring
+    if(captureMovie != MovieStore::NO_MOVIE && movies.isResident(captureMovie)) {
+        movies.getAssets(captureMovie).closeMedia();
+    }
+    if(captureMovie != MovieStore::NO_MOVIE && isCaptureMovieAcquired && !galaxies.isPaged(movies, captureMovie)) {
+        movies.releaseAssets(captureMovie);
+    }
+    captureMovie = MovieStore::NO_MOVIE;
+}
+
+
+//--------------------------------------------------------------
+string ofApp::getArgument(const vector<string> & args, string name) {
+    for(size_t i = 0; i + 1 < args.size(); i++) {
+        if(args[i] == name) {
+            return args[i + 1];
+        }
+    }
+    return "";
+}
+
+
+//--------------------------------------------------------------
+void ofApp::keyReleased(int key){
+    //during the replay the real keyboard is ignored
+    if(recorder.isReplaying() && !recorder.isDispatching()) {
+        return;
+    }
+    recorder.recordKeyReleased(key);
+    
+    //reset camera position
+    if(key == 'q' && movieSelected != MovieStore::NO_MOVIE &&
+        !isBoxRotating()) {   //during the rotation of the selected movie box, the camera position is not reset
+        leaveMovie();
+    } else if(key == 'q' && movieSelected == MovieStore::NO_MOVIE && currentGalaxy >= 0 && galaxies.size() > 1) {
+        leaveGalaxy();   //back to the overview of all clusters
     }
     
     //rotation of the selected movie box
-    if(movieSelected != NULL && movieSelected -> getRotationStep() == 0) {   //the box rotates only if the previous
-                                                                             //rotation is over
+    if(movieSelected != MovieStore::NO_MOVIE && !isBoxRotating()) {   //the box rotates only if the previous
+                                                                      //rotation is over
         if(key == OF_KEY_RIGHT) {   //rotation of the movie box to show right side of the box
-            rotateBoxRight = true;
+            simulation.rotateBox(1, FilmBox::getRotationSpeed());
         }
         
         if(key == OF_KEY_LEFT) {   //rotation of the movie box to show left side of the box
-            rotateBoxLeft = true;
+            simulation.rotateBox(-1, FilmBox::getRotationSpeed());
         }
     }
 }
@@ -431,6 +1281,12 @@ void ofApp::keyReleased(int key){
 
 //--------------------------------------------------------------
 void ofApp::mouseMoved(int x, int y ){
+    //during the replay the real mouse is ignored
+    if(recorder.isReplaying() && !recorder.isDispatching()) {
+        return;
+    }
+    recorder.recordMouseMoved(x, y);
+    
     //the ray starts at camera position and it ends at mouse position
     mousepicker.setFromCamera(glm::vec2(x, y), camera);
 }
@@ -438,51 +1294,62 @@ void ofApp::mouseMoved(int x, int y ){
 
 //--------------------------------------------------------------
 void ofApp::mouseReleased(int x, int y, int button){
+    //during the replay the real mouse is ignored
+    if(recorder.isReplaying() && !recorder.isDispatching()) {
+        return;
+    }
+    recorder.recordMouseReleased(x, y, button);
 
-    //check if the mouse is hover a movie box
-    if(foundIntersection && !scrollBoxEnable && !isZoomingInsideBox){
-        movieSelected = &movies[indexIntersectedPrimitive];   //points to the movie box currently selected
-        targetBoxPosition = movies[indexIntersectedPrimitive].getWorldPosBox();   //update 'targetPoxPosition' to the
-                                                                                      //position of the currently selected
-                                                                                      //movie box
-        moveCameraEnabled = true;    //camera is moving
-        isZoomingInsideBox = true;   //camera is zooming inside the selected movie box
-            
-        //disable Oscar lights
-        lFace.disable();
-        lBody.disable();
-        lHeadRight.disable();
-        lHeadLeft.disable();
-        lBodyRight.disable();
-        lBodyLeft.disable();
-        lBase.disable();
-            
-        //enable light inside selected movie box
-        lightBox.setPosition(movies[indexIntersectedPrimitive].getWorldPosBox());
-        lightBox.lookAt(ofPoint(movies[indexIntersectedPrimitive].getWorldPosBox().x,
-                                movies[indexIntersectedPrimitive].getWorldPosBox().y,
-                                movies[indexIntersectedPrimitive].getWorldPosBox().z - 1)); //illuminates frontal face
-        lightBox.enable();
-        
-        //enable audio
-        movies[indexIntersectedPrimitive].settingAudioControls(true);   //play soundtrack of the selected movie box
+    //check if the mouse is hover a movie box of the current cluster or a far cluster
+    if(foundIntersection && !simulation.getSnapshot().isScrolling && !isZoomingInsideBox &&
+       movies.getGalaxy(indexIntersectedPrimitive) == currentGalaxy){
+        selectMovie(indexIntersectedPrimitive);
+    } else if(hoveredGalaxy >= 0 && !isZoomingInsideBox) {
+        enterGalaxy(hoveredGalaxy);
     }
     
+    //with a box display, the opened box is not shown in this window
+    if(!boxWindow && isOnTrailer(camera, ofGetCurrentViewport(), mouseX, mouseY)) {
+        movies.getAssets(movieSelected).settingVideoControls();   //play or pause the video trailer
+    }
+}
+
+
+//--------------------------------------------------------------
+bool ofApp::isOnTrailer(ofCamera & view, const ofRectangle & viewport, int x, int y) {
     //check if the camera is currently showing the cube face with the trailer
-    if(movieSelected != NULL) {
-        
-        //screen coordinates of top-left corner and bottom-right corner of the trailer
-        ofPoint topLeftScreenVideo = camera.worldToScreen(movieSelected -> getTrailerCoords()[0]);
-        ofPoint bottomRightScreenVideo = camera.worldToScreen(movieSelected -> getTrailerCoords()[1]);
-        
-        //check if the camera is showing the correct cube face
-        if(movieSelected -> getRotationBox() % 180 == 0 && movieSelected -> getRotationBox() != 0) {
-            //check if the mouse has clicked on the video
-            if(mouseX >= topLeftScreenVideo.x && mouseX <= bottomRightScreenVideo.x &&
-               mouseY >= topLeftScreenVideo.y && mouseY <= bottomRightScreenVideo.y) {
+    if(movieSelected == MovieStore::NO_MOVIE) {
+        return false;
+    }
+    
+    //check if the camera is showing the correct cube face
+    int rotation = movies.getRotation(movieSelected);
+    if(rotation % 180 != 0 || rotation == 0) {
+        return false;
+    }
+    
+    //screen coordinates of top-left corner and bottom-right corner of the trailer
+    ofPoint topLeftVideo, bottomRightVideo;
+    FilmBox::getTrailerCoords(movies.getWorldPosition(movieSelected), topLeftVideo, bottomRightVideo);
+    ofPoint topLeftScreenVideo = view.worldToScreen(topLeftVideo, viewport);
+    ofPoint bottomRightScreenVideo = view.worldToScreen(bottomRightVideo, viewport);
+    
+    //check if the mouse has clicked on the video
+    return x >= topLeftScreenVideo.x && x <= bottomRightScreenVideo.x &&
+           y >= topLeftScreenVideo.y && y <= bottomRightScreenVideo.y;
+}
 
-                movieSelected -> settingVideoControls();   //play or pause the video trailer
-            }
-        }
+
+//--------------------------------------------------------------
+void ofApp::mouseScrolled(int x, int y, float scrollX, float scrollY){
+    //during the replay the real mouse is ignored
+    if(recorder.isReplaying() && !recorder.isDispatching()) {
+        return;
+    }
+    recorder.recordMouseScrolled(x, y, scrollY);
+    
+    //the ring slides only when the camera is in front of it
+    if(!isZoomingInsideBox && currentGalaxy >= 0) {
+        simulation.scroll(scrollY);   //each wheel step pushes the ring, the speed decays in the simulation
     }
 }
@@ -1,16 +1,31 @@
 #pragma once
 
 #include "ofMain.h"
-#include "FilmBox.h"
+#include "MovieStore.h"
 #include "ofxAssimpModelLoader.h"   //addon to load 3D model
 #include "ofxJSON.h"                //addon to read JSON file
 #include "ofxGui.h"                 //addon to show GUI
 #include "ofxRaycaster.h"           //addon to do raycasting
+#include "InputRecorder.h"
+#include "SoakTest.h"
+#include "MetricsServer.h"
+#include "JobSystem.h"
+#include "RenderList.h"
+#include "GalaxyMap.h"
+#include "FrameCapture.h"
+#include "GpuTimer.h"
+#include "FrameArena.h"
+#include "AllocationTracker.h"
+#include "TextureCache.h"
+#include "Simulation.h"
+#include "StateCache.h"
 
 class ofApp : public ofBaseApp{
     private:
         ofTrueTypeFont font;   //font to use in texts
         string helpText;       //text to show which keyboard commands are currently available
+        string fpsText;        //FPS text, rebuilt only when the value changes
+        int lastFps;           //FPS written in 'fpsText'
     
         //GUI
         ofxPanel boxPanel;                    //ofxPanel instance for movie box parameters
@@ -22,14 +37,16 @@ class ofApp : public ofBaseApp{
     
         //camera
         ofCamera camera;
+        ofCamera boxCamera;          //camera of the box display
+        enum BoxDisplayButton { ROTATE_LEFT, ROTATE_RIGHT, LEAVE_BOX, BOX_DISPLAY_BUTTONS };   //touch controls of the
+                                                                                            //box display
+        bool isBoxDisplayLightReady; //true when the box light has been set up in the GL context of the box display
+        bool isBoxLeaveRequested;    //true if the exit button of the box display was touched
         ofPoint cameraOrigin;        //default camera position
-        ofPoint targetBoxPosition;   //position of the selected movie box
-        bool moveCameraEnabled;      //this flag is true if the camera is moving
         bool isZoomingInsideBox;     //this flag is true if the camera is zooming inside a movie box
     
-        //movie box rotation
-        bool rotateBoxRight;         //this flag is true if the right arrow is pressed
-        bool rotateBoxLeft;          //this flag is true if the left arrow is pressed
+        //simulation
+        Simulation simulation;       //camera tween, box rotation and ring scrolling at a fixed rate on its own thread
     
         //3D model
         ofxAssimpModelLoader model;   //3D model of the Oscar statuette
@@ -39,15 +56,19 @@ class ofApp : public ofBaseApp{
         ofxJSONElement data;   //JSON file containing all movies information
     
         //movies
-        FilmBox * movieSelected;   //pointer to the movie box currently selected
-        vector<FilmBox> movies;    //vector of movies
-        float angle;               //angle where to place the movie box
-        float angleOffset;         //offset angle between movies
+        MovieStore::MovieId movieSelected;   //identifier of the movie box currently selected
+        MovieStore movies;                   //all movies, hot per-frame state and assets are stored separately
         int distance;              //distance of the movies from the Oscar statuette
     
-        //scroll movies
-        float stepScrollBox;   //step box rotation around Oscar statuette 
-        bool scrollBoxEnable;  //this flag is true if movie boxes are sliding around the Oscar statuette
+        //galaxies
+        GalaxyMap galaxies;        //clusters of movies (years or categories), far clusters are drawn as impostors
+        int currentGalaxy;         //cluster around which the camera is, -1 in the overview of all clusters
+        int hoveredGalaxy;         //collapsed cluster pointed by the mouse, -1 if none
+    
+        //per-frame stages
+        JobSystem jobs;                 //worker threads running layout, projection, culling and picking in parallel
+        RenderList renderList;          //result of the stages, written by update and read by the draw of the same frame
+        FrameArena frameArena;          //transient data of the stages, released at the end of each frame
     
         //textures
         ofTexture backgroundImage;   //texture to use as background
@@ -55,11 +76,8 @@ class ofApp : public ofBaseApp{
     
         //raycasting
         ofxraycaster::Mousepicker mousepicker;             //ray from camera position to mouse position
-        glm::vec2 baricentricCoordinates;
-        glm::vec3 surfaceNormal;
-        float dist;
-        bool intersects;                                   //true if the ray intersects a movie box
-        int indexIntersectedPrimitive;                     //index of movie box intersected by the ray
+        float dist;                                        //distance of the nearest movie box intersected by the ray
+        MovieStore::MovieId indexIntersectedPrimitive;     //movie box intersected by the ray
         bool foundIntersection;                            //true if an intersection is found
     
         //lights
@@ -70,21 +88,77 @@ class ofApp : public ofBaseApp{
         ofLight lBody;                   //front light to illuminate the body of the model
         ofLight lBase;                   //light to illuminate the base of the model
     
+        //input recording and replay
+        InputRecorder recorder;   //records or replays the visitor interaction
+        string reportPath;        //file where the frame time and memory report of the run is written
+    
+        //soak test
+        SoakTest soakTest;        //cycles through all movie boxes for hours looking for resource leaks
+    
+        //metrics
+        Metrics metrics;                  //live frame and media statistics
+        MetricsServer metricsServer;      //HTTP endpoint on localhost serving 'metrics'
+        uint64_t frameStartMicros;        //system time at the beginning of the current frame
+        uint64_t drawStartMicros;         //system time at the beginning of ofApp::draw
+        int lastTrailerFrame;             //last trailer frame received from the decoder, -1 if none
+        int lastSoundtrackPosition;       //soundtrack position in milliseconds at the last update
+        uint64_t lastSoundtrackAdvance;   //system time when the soundtrack position last changed
+        bool isSoundtrackStalled;         //true while the soundtrack is not advancing
+        GpuTimer gpuTimer;                //GPU time of background, statuette, boxes, trailer and GUI passes
+    
+        //offscreen capture
+        FrameCapture capture;                  //renders every movie box and the camera paths in PNG files
+        FrameCapture::Shot captureShot;        //frame currently rendered by the capture
+        bool hasCaptureShot;                   //true if 'captureShot' has not been rendered yet
+        bool isCaptureShotReady;               //true when 'captureShot' can be drawn in the current frame
+        MovieStore::MovieId captureMovie;      //movie whose assets are used by the capture
+        bool isCaptureMovieAcquired;           //true if the assets of 'captureMovie' were loaded by the capture
+    
 	public:
+        vector<string> arguments;   //command line arguments of the application
+        shared_ptr<ofAppBaseWindow> boxWindow;   //second display showing the opened box, null if not used
+    
 		void setup();
 		void update();
 		void draw();
         void exit();
-        void getData(string file);           //retrieves data stored in JSON file and saves them in vector 'movies'
-        void moveCamera(ofPoint target);     //moves the camera inside and outside the movie box
-        void rotateMovieBox();               //rotates the selected movie box when right or left arrow key is released
+        void drawScene(float width, float height);   //draws background, statuettes, boxes and galaxies with 'camera'
+        void getData(string file);           //retrieves data stored in JSON file and saves them in 'movies'
+        void addCatalog(ofxJSONElement & catalog);   //adds the movies of a catalog to their clusters
+        void enterGalaxy(int galaxy);        //moves the camera in front of the cluster 'galaxy'
+        void leaveGalaxy();                  //moves the camera back to the overview of all clusters
+        void selectMovie(MovieStore::MovieId id);   //moves the camera inside the movie box 'id'
+        void leaveMovie();                   //moves the camera outside the selected movie box
+        bool isBoxRotating();                //true if the selected movie box is rotating or about to rotate
+        void updateRenderList();             //layout, projection, culling and picking of all boxes in parallel
         void drawBoxesAndSelection();        //draws boxes around the Oscar and highlights the selected one
         void setupLights();                  //setup the lights of the Oscar statuette
+        void setupBoxLight();                //setup the light inside the selected movie box
+        void enableOscarLights(bool b);      //turns on or off the lights of the Oscar statuette
         void updatePositionLights();         //update positions lights of the Oscar statuette
         void showHelp();                     //show possible keyboard commands
         void modelRotation();                //rotates the model by 180° on the y axis
         void setupGUIs();                    //setups GUIs
+        void setupInputRecorder();           //starts recording or replaying input if requested by command line
+        void replayInput();                  //sends to the application the recorded events of the current frame
+        void updateSoakTest();               //performs the next action of the soak test and samples resource usage
+        void setupMetrics();                 //starts the metrics endpoint if requested by command line
+        void updateMetrics();                //updates view, selection and media counters of 'metrics'
+        void setupBoxDisplay();              //draws the box display with this application
+        void drawBoxDisplay(ofEventArgs & args);                //draws the opened box on the box display
+        void boxDisplayMouseReleased(ofMouseEventArgs & args);  //rotates or leaves the opened box, plays or pauses
+                                                                //its trailer on the box display
+        void drawBoxDisplayButtons();                           //draws the touch controls of the box display
+        ofRectangle getBoxDisplayButton(BoxDisplayButton button);   //area of 'button' on the box display
+        bool isOnTrailer(ofCamera & view, const ofRectangle & viewport, int x, int y);   //true if (x, y) is on the
+                                                                                      //trailer of the opened box
+        void setupCapture();                 //starts the offscreen capture if requested by command line
+        void updateCapture();                //moves the camera for the next frame of the capture
+        void drawCapture();                  //draws the current frame of the capture and queues its readback
+        void releaseCaptureMovie();          //unloads the assets loaded only for the capture
+        static string getArgument(const vector<string> & args, string name);   //value following 'name' in 'args'
 		void keyReleased(int key);
 		void mouseMoved(int x, int y );
         void mouseReleased(int x, int y, int button);
+        void mouseScrolled(int x, int y, float scrollX, float scrollY);
 };